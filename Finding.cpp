@@ -116,6 +116,24 @@ CFindDlg dlg (FindInfo.m_strFindStringList);
       FindInfo.m_regexp = regcomp (FindInfo.m_strFindStringList.GetHead (),
       (FindInfo.m_bMatchCase ? 0 :  PCRE_CASELESS) | (FindInfo.m_bUTF8 ? PCRE_UTF8 : 0));
 
+    // work out which trigrams a matching line must contain, so that the
+    // "get next line" callback can skip lines without them (see TextSignature.h)
+    // - for a case-insensitive search we don't know how MakeLower folds non-ASCII text
+    // - for a regexp, only the text every match must contain (see ExtractRequiredLiteral),
+    //   anything less certain (eg. the digits of \d{2,3}) would skip lines which match
+
+    FindInfo.m_signature.Clear ();
+    if (FindInfo.m_bRegexp)
+      {
+      const string & sLiteral = FindInfo.m_regexp->m_sRequiredLiteral;
+      FindInfo.m_signature.Add (NULL, 0, sLiteral.c_str (), sLiteral.size ());
+      }
+    else
+      FindInfo.m_signature.Add (NULL, 0, 
+                                FindInfo.m_strFindStringList.GetHead (), 
+                                FindInfo.m_strFindStringList.GetHead ().GetLength (),
+                                !FindInfo.m_bMatchCase);
+
     }   // end of not starting a new find
   else
     {  // finding again
@@ -3,6 +3,31 @@
 
 #include "doc.h"
 
+// These use placement new, so they must come before DEBUG_NEW is defined
+
+// makes a new line, in the world's line arena
+
+CLine * NewLine (const long nLineNumber, 
+                 const unsigned int nWrapColumn,
+                 const unsigned short iFlags,      
+                 const COLORREF       iForeColour,
+                 const COLORREF       iBackColour,
+                 const bool bUnicode,
+                 CLineArena & LineArena,
+                 CLineArena & TextArena)
+  {
+  return new (LineArena) CLine (nLineNumber, nWrapColumn, 
+                                iFlags, iForeColour, iBackColour, bUnicode,
+                                LineArena, TextArena);
+  } // end of NewLine
+
+// makes a new style, in the world's line arena
+
+CStyle * NewStyle (CLineArena & arena)
+  {
+  return new (arena) CStyle;
+  } // end of NewStyle
+
 #ifdef _DEBUG
 #define new DEBUG_NEW
 #undef THIS_FILE
@@ -20,6 +45,9 @@ static char BASED_CODE THIS_FILE[] = __FILE__;
   Also, the constructor allocates memory for the text of the line and its first
   style item, and the destructor de-allocates the line's memory, and the style list.
 
+  The lines, their text and their styles all come from the world's arenas
+  (see LineArena.h).
+
 */
 
 // CLine constructor
@@ -29,7 +57,9 @@ CLine::CLine (const long nLineNumber,
               const unsigned short iFlags,      
               const COLORREF       iForeColour,
               const COLORREF       iBackColour,
-              const bool bUnicode
+              const bool bUnicode,
+              CLineArena & LineArena,
+              CLineArena & TextArena
               )
   {
   hard_return = false;
@@ -47,20 +77,14 @@ CLine::CLine (const long nLineNumber,
 
   // allocate 4 bytes per character for UTF-8
 
-#ifdef USE_REALLOC
-  text = (char *) malloc (iMemoryAllocated);
-#else
-  text = new char [iMemoryAllocated];
-#endif
-  ASSERT (text);
-  if (!text)
-    AfxThrowMemoryException ();
+  // (throws a memory exception if it can't)
+  text = (char *) TextArena.Allocate (iMemoryAllocated);
   flags = 0;      // no special flags yet (ie. normal output line)
 
   CStyle * pStyle; 
 
   // have at least one style item in the list
-  styleList.AddTail (pStyle = NEWSTYLE);
+  styleList.AddTail (pStyle = NewStyle (LineArena));
 
   pStyle->iFlags = iFlags;
   pStyle->iForeColour = iForeColour;
@@ -72,11 +96,7 @@ CLine::CLine (const long nLineNumber,
 
 CLine::~CLine ()
   {
-#ifdef USE_REALLOC
-  free (text);
-#else
-  delete [] text;
-#endif
+  CLineArena::Free (text);
 
 // delete styles list
 
@@ -87,11 +107,50 @@ CLine::~CLine ()
 
   }
 
+// give the line a new text buffer (eg. the wrap column changed), keeping its text
+
+void CLine::ResizeText (CLineArena & TextArena, const int iSize)
+  {
+  char * pNewText = (char *) TextArena.Allocate (iSize);
+
+  memcpy (pNewText, text, MIN (len, iSize));
+  CLineArena::Free (text);
+
+  text = pNewText;
+  iMemoryAllocated = iSize;
+  } // end of CLine::ResizeText
+
+// note which trigrams the finished line contains (see TextSignature.h)
+
+void CLine::Sign (const CLine * pPreviousLine)
+  {
+
+  m_signature.Clear ();
+
+  // first line of a paragraph? just this text
+  if (pPreviousLine == NULL || pPreviousLine->hard_return)
+    {
+    m_signature.Add (NULL, 0, text, len);
+    return;
+    }
+
+  // wrapped - trigrams can span from the previous line, but if that was
+  // very short they could span two lines, so don't try to be clever
+  if (pPreviousLine->len < 2)
+    {
+    m_signature.SetAll ();
+    return;
+    }
+
+  m_signature.Add (&pPreviousLine->text [pPreviousLine->len - 2], 2, text, len);
+
+  } // end of CLine::Sign
+
 // for tracking down style allocation errors
 
-CStyle * GetNewStyle (const char * filename, const long linenumber)
+CStyle * GetNewStyle (CLineArena & arena, const char * filename, const long linenumber)
   {
-  CStyle * pNewStyle = new CStyle;
+  CStyle * pNewStyle = NewStyle (arena);
   TRACE3 ("new CStyle at %p at file %s line %ld\n",
           pNewStyle,
           filename,
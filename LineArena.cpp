@@ -0,0 +1,146 @@
+// LineArena.cpp - slab allocator for output buffer lines, their text and styles
+
+// See LineArena.h for an explanation.
+
+#include "stdafx.h"
+#include "MUSHclient.h"
+#include "doc.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char BASED_CODE THIS_FILE[] = __FILE__;
+#endif
+
+// blocks start after the slab header, suitably aligned for anything
+#define SLAB_HEADER_SIZE ((sizeof (tSlab) + 7) & ~7)
+
+CLineArena::CLineArena (const int iAlignment)
+  {
+  m_pCurrent = NULL;
+  m_pSlabs = NULL;
+  m_iAlignment = iAlignment;
+  m_iSlabCount = 0;
+  m_iBytesAllocated = 0;
+  } // end of CLineArena::CLineArena
+
+CLineArena::~CLineArena ()
+  {
+  // everything should have been freed by now, but release the slabs anyway
+  while (m_pSlabs)
+    FreeSlab (m_pSlabs);
+  } // end of CLineArena::~CLineArena
+
+CLineArena::tSlab * CLineArena::NewSlab (const int iSize)
+  {
+  tSlab * pSlab = (tSlab *) VirtualAlloc (NULL, iSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+  if (!pSlab)
+    AfxThrowMemoryException ();
+
+  pSlab->pArena = this;
+  pSlab->iBlocksInUse = 0;
+  pSlab->iSize = iSize;
+  pSlab->pFree = (char *) pSlab + SLAB_HEADER_SIZE;
+  pSlab->pEnd = (char *) pSlab + iSize;
+
+  // add to list of all slabs
+  pSlab->pPrevious = NULL;
+  pSlab->pNext = m_pSlabs;
+  if (m_pSlabs)
+    m_pSlabs->pPrevious = pSlab;
+  m_pSlabs = pSlab;
+
+  m_iSlabCount++;
+  m_iBytesAllocated += iSize;
+
+  return pSlab;
+  } // end of CLineArena::NewSlab
+
+void CLineArena::FreeSlab (tSlab * pSlab)
+  {
+  if (pSlab->pPrevious)
+    pSlab->pPrevious->pNext = pSlab->pNext;
+  else
+    m_pSlabs = pSlab->pNext;
+
+  if (pSlab->pNext)
+    pSlab->pNext->pPrevious = pSlab->pPrevious;
+
+  if (pSlab == m_pCurrent)
+    m_pCurrent = NULL;
+
+  m_iSlabCount--;
+  m_iBytesAllocated -= pSlab->iSize;
+
+  VirtualFree (pSlab, 0, MEM_RELEASE);
+  } // end of CLineArena::FreeSlab
+
+void * CLineArena::Allocate (int iSize)
+  {
+  iSize = Round (MAX (iSize, 1));
+
+  // too big for a normal slab? give it one of its own
+  //  (nothing else goes in it, as blocks must start in the first ARENA_SLAB_SIZE bytes)
+  if (iSize > (int) (ARENA_SLAB_SIZE - SLAB_HEADER_SIZE))
+    {
+    tSlab * pSlab = NewSlab ((SLAB_HEADER_SIZE + iSize + ARENA_SLAB_SIZE - 1) & ~(ARENA_SLAB_SIZE - 1));
+    char * p = pSlab->pFree;
+    pSlab->pFree = pSlab->pEnd;
+    pSlab->iBlocksInUse++;
+    return p;
+    }
+
+  // current slab full? start another one
+  if (m_pCurrent == NULL || (m_pCurrent->pEnd - m_pCurrent->pFree) < iSize)
+    {
+    tSlab * pOldSlab = m_pCurrent;
+
+    m_pCurrent = NewSlab (ARENA_SLAB_SIZE);
+
+    // nothing left in the old one?
+    if (pOldSlab && pOldSlab->iBlocksInUse == 0)
+      FreeSlab (pOldSlab);
+    }
+
+  char * p = m_pCurrent->pFree;
+  m_pCurrent->pFree += iSize;
+  m_pCurrent->iBlocksInUse++;
+  return p;
+  } // end of CLineArena::Allocate
+
+bool CLineArena::Shrink (void * p, int iOldSize, int iNewSize)
+  {
+  iOldSize = Round (MAX (iOldSize, 1));
+  iNewSize = Round (MAX (iNewSize, 1));
+
+  // we can only give back the end of the most recent block in the current slab
+  if (m_pCurrent == NULL ||
+      (char *) p + iOldSize != m_pCurrent->pFree ||
+      iNewSize > iOldSize)
+    return false;
+
+  m_pCurrent->pFree = (char *) p + iNewSize;
+  return true;
+  } // end of CLineArena::Shrink
+
+void CLineArena::Free (void * p)
+  {
+  if (p == NULL)
+    return;
+
+  // slabs are aligned on ARENA_SLAB_SIZE, and blocks start in the first ARENA_SLAB_SIZE bytes
+  tSlab * pSlab = (tSlab *) ((char *) p - ((unsigned long) p & (ARENA_SLAB_SIZE - 1)));
+
+  ASSERT (pSlab->iBlocksInUse > 0);
+
+  if (--pSlab->iBlocksInUse > 0)
+    return;   // still in use
+
+  // the current slab can be used again from the start
+  if (pSlab == pSlab->pArena->m_pCurrent)
+    pSlab->pFree = (char *) pSlab + SLAB_HEADER_SIZE;
+  else
+    pSlab->pArena->FreeSlab (pSlab);
+
+  } // end of CLineArena::Free
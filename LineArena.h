@@ -0,0 +1,82 @@
+// LineArena.h - slab allocator for output buffer lines, their text and styles
+
+#pragma once
+
+/*
+
+  Every line in the output buffer used to be at least three small heap blocks
+  (the CLine, its text and a CStyle), plus one more for each style change. With
+  a large scrollback that is hundreds of thousands of tiny blocks, which
+  fragments the heap and makes throwing lines away (RemoveChunk) slow.
+
+  Instead, each world carves them out of 64 Kb slabs. A slab counts how many
+  blocks in it are still in use, and is released as a whole when that reaches
+  zero. Lines are discarded oldest first (JUMP_SIZE at a time, by RemoveChunk)
+  so slabs empty in the same order that they were filled.
+
+  Slabs are allocated with VirtualAlloc, so they are aligned on ARENA_SLAB_SIZE,
+  and the slab a block belongs to can be found from its address alone. Thus
+  blocks need no header at all.
+
+  Freed blocks are not reused individually - the memory comes back when the
+  whole slab is released. The exception is Shrink, which lets the most recent
+  block give back its unused end (eg. a line's text, once we know how long the
+  line is).
+
+*/
+
+#define ARENA_SLAB_SIZE 0x10000   // 64 Kb - the VirtualAlloc granularity
+
+class CLineArena
+  {
+  public:
+
+  CLineArena (const int iAlignment);  // eg. 8 for objects, 1 for text
+  ~CLineArena ();
+
+  // get memory - throws a memory exception if none is available
+  void * Allocate (int iSize);
+
+  // make the most recent block smaller - returns false if it isn't the most recent
+  bool Shrink (void * p, int iOldSize, int iNewSize);
+
+  // give back a block from any arena
+  static void Free (void * p);
+
+  // statistics
+  long GetSlabCount (void) const { return m_iSlabCount; };
+  __int64 GetBytesAllocated (void) const { return m_iBytesAllocated; };
+
+  private:
+
+  struct tSlab
+    {
+    CLineArena * pArena;    // which arena it belongs to
+    tSlab * pPrevious;      // all slabs in this arena, so the destructor can find them
+    tSlab * pNext;
+    long iBlocksInUse;      // when zero, the slab can go
+    long iSize;             // bytes in slab, including this header
+    char * pFree;           // next free byte
+    char * pEnd;            // end of slab
+    };
+
+  tSlab * NewSlab (const int iSize);
+  void FreeSlab (tSlab * pSlab);
+  int Round (const int iSize) const
+    { return (iSize + m_iAlignment - 1) & ~(m_iAlignment - 1); };
+
+  tSlab * m_pCurrent;       // where we are allocating from
+  tSlab * m_pSlabs;         // list of all slabs
+  int m_iAlignment;         // power of 2
+  long m_iSlabCount;
+  __int64 m_iBytesAllocated;
+
+  // not copyable
+  CLineArena (const CLineArena &);
+  CLineArena & operator= (const CLineArena &);
+
+  };
+
+// make a style, in this arena (see NEWSTYLE in stdafx.h)
+class CStyle;
+CStyle * NewStyle (CLineArena & arena);
@@ -0,0 +1,116 @@
+// LineList.cpp - the output buffer lines, as a ring buffer
+
+// See LineList.h for an explanation.
+
+#include "stdafx.h"
+#include "MUSHclient.h"
+#include "doc.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char BASED_CODE THIS_FILE[] = __FILE__;
+#endif
+
+CLineList::CLineList ()
+  {
+  m_pLines = NULL;
+  m_nMask = -1;     // capacity of zero
+  m_nHead = 0;
+  m_nCount = 0;
+  m_nHeadSequence = 0;
+  } // end of CLineList::CLineList
+
+CLineList::~CLineList ()
+  {
+  // the document deletes the lines themselves
+  delete [] m_pLines;
+  } // end of CLineList::~CLineList
+
+void CLineList::SetCapacity (const long nLines)
+  {
+  long nNewSize = 16;
+
+  // we can't throw away lines here - see RemoveChunk
+  while (nNewSize < nLines || nNewSize < m_nCount)
+    nNewSize <<= 1;
+
+  if (nNewSize == GetCapacity ())
+    return;   // no change
+
+  CLine ** pNewLines = new CLine * [nNewSize];
+
+  // copy existing lines to the start of the new ring
+  for (long i = 0; i < m_nCount; i++)
+    pNewLines [i] = GetLine (i);
+
+  delete [] m_pLines;
+  m_pLines = pNewLines;
+  m_nMask = nNewSize - 1;
+  m_nHead = 0;
+
+  } // end of CLineList::SetCapacity
+
+POSITION CLineList::AddTail (CLine * pLine)
+  {
+  // full? (normally RemoveChunk will have made room)
+  if (m_nCount > m_nMask)
+    SetCapacity (m_nCount + 1);
+
+  m_pLines [(m_nHead + m_nCount) & m_nMask] = pLine;
+  m_nCount++;
+
+  return GetTailPosition ();
+  } // end of CLineList::AddTail
+
+CLine * CLineList::RemoveHead (void)
+  {
+  CLine * pLine = GetHead ();
+
+  m_nHead = (m_nHead + 1) & m_nMask;
+  m_nCount--;
+  m_nHeadSequence++;    // existing positions are still correct
+
+  return pLine;
+  } // end of CLineList::RemoveHead
+
+CLine * CLineList::RemoveTail (void)
+  {
+  CLine * pLine = GetTail ();
+
+  m_nCount--;
+
+  return pLine;
+  } // end of CLineList::RemoveTail
+
+CLine * CLineList::GetNext (POSITION & pos) const
+  {
+  long nLine = GetIndex (pos);
+
+  ASSERT (nLine >= 0);
+
+  if (nLine < 0)
+    {
+    pos = NULL;   // stale position - line has gone
+    return NULL;
+    }
+
+  pos = GetPosition (nLine + 1);
+  return GetLine (nLine);
+  } // end of CLineList::GetNext
+
+CLine * CLineList::GetPrev (POSITION & pos) const
+  {
+  long nLine = GetIndex (pos);
+
+  ASSERT (nLine >= 0);
+
+  if (nLine < 0)
+    {
+    pos = NULL;   // stale position - line has gone
+    return NULL;
+    }
+
+  pos = GetPosition (nLine - 1);
+  return GetLine (nLine);
+  } // end of CLineList::GetPrev
@@ -0,0 +1,104 @@
+// LineList.h - the output buffer lines, as a ring buffer
+
+#pragma once
+
+/*
+
+  The output buffer used to be a CTypedPtrList of lines, with the position of
+  every JUMP_SIZE'th line remembered in a separate array. Finding line n meant
+  looking up the nearest remembered position, and then walking up to 99 list
+  nodes forwards. Every line also cost a list node (12 bytes plus a heap header),
+  and discarding old lines meant shuffling the positions array down.
+
+  Now the lines are kept in a single array, used as a ring buffer. The oldest
+  line is at m_nHead, and line n is at (m_nHead + n) & m_nMask, so finding it
+  takes constant time, and RemoveHead just moves m_nHead along.
+
+  For compatibility with the rest of the code, the familiar list functions
+  (AddTail, RemoveHead, GetNext, GetPrev and so on) are provided. A POSITION is
+  the sequence number of the line (counting every line ever added, plus one),
+  not an address, so it stays valid while older lines are discarded from the
+  head, and can be checked. A stale position (for a line since discarded)
+  behaves like the end of the list.
+
+  The lines themselves, their text and their styles come from the arenas in
+  the document (see LineArena.h).
+
+*/
+
+class CLine;
+
+class CLineList
+  {
+  public:
+
+  CLineList ();
+  ~CLineList ();
+
+  // make room for at least this many lines, keeping any we have
+  void SetCapacity (const long nLines);
+  long GetCapacity (void) const { return m_nMask + 1; };
+
+  // memory used by the ring itself (not the lines)
+  long GetMemoryUsed (void) const { return GetCapacity () * sizeof (CLine *); };
+
+  long GetCount (void) const { return m_nCount; };
+  BOOL IsEmpty (void) const { return m_nCount == 0; };
+
+  // direct access - line 0 is the oldest
+  CLine * GetLine (const long nLine) const
+    {
+    ASSERT (nLine >= 0 && nLine < m_nCount);
+    return m_pLines [(m_nHead + nLine) & m_nMask];
+    };
+
+  // position of a line number, or NULL if there is no such line
+  POSITION GetPosition (const long nLine) const
+    {
+    if (nLine < 0 || nLine >= m_nCount)
+      return NULL;
+    return (POSITION) (m_nHeadSequence + nLine + 1);
+    };
+
+  // list-style interface
+  POSITION AddTail (CLine * pLine);
+  CLine * RemoveHead (void);
+  CLine * RemoveTail (void);
+
+  CLine * GetHead (void) const { return GetLine (0); };
+  CLine * GetTail (void) const { return GetLine (m_nCount - 1); };
+
+  POSITION GetHeadPosition (void) const { return GetPosition (0); };
+  POSITION GetTailPosition (void) const { return GetPosition (m_nCount - 1); };
+
+  CLine * GetAt (POSITION pos) const
+    {
+    long nLine = GetIndex (pos);
+    ASSERT (nLine >= 0);
+    return nLine < 0 ? NULL : GetLine (nLine);
+    };
+  CLine * GetNext (POSITION & pos) const;
+  CLine * GetPrev (POSITION & pos) const;
+
+  private:
+
+  // line number of a position, or -1 if it is no longer (or not yet) in the buffer
+  long GetIndex (POSITION pos) const
+    {
+    unsigned long nOffset = (unsigned long) pos - 1 - m_nHeadSequence;
+    if (pos == NULL || nOffset >= (unsigned long) m_nCount)
+      return -1;
+    return (long) nOffset;
+    };
+
+  CLine ** m_pLines;              // the ring - size is a power of 2
+  long m_nMask;                   // size of ring, minus 1
+  long m_nHead;                   // where the oldest line is
+  long m_nCount;                  // how many lines we have
+  unsigned long m_nHeadSequence;  // sequence number of the oldest line
+
+  // not copyable
+  CLineList (const CLineList &);
+  CLineList & operator= (const CLineList &);
+
+  };
@@ -1369,6 +1369,7 @@ bool CMUSHclientApp::SpellCheck (CWnd * pWnd, CEdit * pEdit)
 
 
 LUALIB_API int luaopen_progress_dialog(lua_State *L);
+LUALIB_API int luaopen_spell(lua_State *L);
 
 void CMUSHclientApp::OpenLuaDelayed ()
   {
@@ -1388,6 +1389,7 @@ void CMUSHclientApp::OpenLuaDelayed ()
   CallLuaCFunction (m_SpellChecker_Lua, luaopen_bc);             // open bc library   
   CallLuaCFunction (m_SpellChecker_Lua, luaopen_lsqlite3);       // open sqlite library
   CallLuaCFunction (m_SpellChecker_Lua, luaopen_lpeg);           // open lpeg library
+  CallLuaCFunction (m_SpellChecker_Lua, luaopen_spell);          // spell checker dictionary
 
   // add xml reader to utils lib
   luaL_register (m_SpellChecker_Lua, "utils", ptr_xmllib);
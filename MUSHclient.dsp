@@ -167,6 +167,14 @@ SOURCE=.\Line.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\LineArena.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\LineList.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\Mapping.cpp
 # End Source File
 # Begin Source File
@@ -223,6 +231,10 @@ SOURCE=.\StatLink.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\SpellDictionary.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\stdafx.cpp
 # ADD BASE CPP /Yc"stdafx.h"
 # ADD CPP /Yc"stdafx.h"
@@ -245,6 +257,14 @@ SOURCE=.\TimerWnd.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\TriggerPrefilter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TextSignature.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\UDPsocket.cpp
 # End Source File
 # Begin Source File
@@ -1179,6 +1199,10 @@ SOURCE=.\scripting\lua_progressdlg.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\scripting\lua_spell.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\scripting\lua_scripting.cpp
 # End Source File
 # Begin Source File
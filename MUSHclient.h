@@ -11,6 +11,7 @@
 #include "hostsite.h"
 #include "scripting\scripting.h"
 #include "othertypes.h"
+#include "SpellDictionary.h"
 
 #define DIRECTSOUND_VERSION 5
 
@@ -43,6 +44,11 @@
 class CActivityDoc;
 class CActivityView;
 class CTextDocument;
+class CMUSHclientDoc;
+
+// world documents currently in existence, keyed by their unique document number
+typedef map<__int64, CMUSHclientDoc *> CWorldDocumentMap;
+typedef CWorldDocumentMap::iterator CWorldDocumentMapIterator;
 
 extern COLORREF xterm_256_colours [256];
 
@@ -68,8 +74,11 @@ public:
 	CMultiDocTemplate* m_pActivityDocTemplate;
 	CMultiDocTemplate* m_pNormalDocTemplate;    // text document
 
+  CWorldDocumentMap m_WorldDocuments;   // live worlds, for validating script handles
+
   CAtomicElementMap  m_ElementMap;   // MXP elements we know of (eg. <b> )
   CMapStringToString m_EntityMap;    // MXP entities we know of (eg. &lt; )
+  CEntityTable m_EntityTable;        // the same, for fast lookup
   CColoursMap        m_ColoursMap;   // MXP colours we know of (eg. blue)
 
   BOOL m_bUpdateActivity;
@@ -99,6 +108,7 @@ public:
   __int64 m_nUniqueNumber;
 
   lua_State           * m_SpellChecker_Lua;     // Lua state - spellchecker
+  CSpellDictionary      m_SpellDictionary;      // words known to the spellchecker
   lua_State           * m_Translator_Lua;       // Lua state - translation (i18n)
 
   CString m_strTranslatorFile;    // eg. (MUSHclient executable)\locale\EN.lua
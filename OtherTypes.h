@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "LineArena.h"
+#include "LineList.h"
+
 #define DEFAULT_TRIGGER_SEQUENCE 100
 #define DEFAULT_ALIAS_SEQUENCE 100
 
@@ -193,6 +196,7 @@ class CAction : public CObject
   CString m_strHint;     // Hint - flyover hint, and prompts for actions
   CString m_strVariable; // which variable to set (FLAG in MXP)
   unsigned long m_iHash;       // for quick lookups - hash of action, hint, variable
+  POSITION m_pos;              // where it is in m_ActionList (so Release need not search)
 
   protected: 
 
@@ -220,6 +224,9 @@ class CAction : public CObject
 
 typedef CTypedPtrList <CPtrList, CAction*> CActionList;
 
+// the same actions, by m_iHash - different actions may have the same hash
+typedef multimap<unsigned long, CAction*> CActionHashMap;
+
 /*
   25 May 2001.
 
@@ -296,6 +303,11 @@ class CStyle : public CObject
       pAction->Release ();
     };  // destructor
 
+  // styles live in the world's line arena - use NEWSTYLE to make one
+  void * operator new (size_t nSize, CLineArena & arena) { return arena.Allocate (nSize); };
+  void operator delete (void * p, CLineArena &) { CLineArena::Free (p); };
+  void operator delete (void * p) { CLineArena::Free (p); };
+
   };
 
 typedef CTypedPtrList <CPtrList, CStyle*> CStyleList;
@@ -323,7 +335,7 @@ class CLine : public CObject
   unsigned char flags;
   int len;
   int last_space;
-  char * text;          // allocated as necessary and then resized
+  char * text;          // allocated in the text arena, and then shrunk
   CStyleList styleList; // list of styles applying to text, see above
   CTime m_theTime;      // time this line arrived
   LARGE_INTEGER m_lineHighPerformanceTime;  
@@ -332,18 +344,103 @@ class CLine : public CObject
   long m_nLineNumber;
   short m_iPreambleOffset;  // how far in the preamble took us
 
+  CTextSignature m_signature;   // trigrams in the text, for finding
+
   CLine (const long nLineNumber, 
          const unsigned int nWrapColumn,
          const unsigned short iFlags,      
          const COLORREF       iForeColour,
          const COLORREF       iBackColour,
-         const bool bUnicode 
+         const bool bUnicode,
+         CLineArena & LineArena,     // for styles
+         CLineArena & TextArena      // for text
          );   // constructor
   ~CLine ();    // destructor
 
+  // give the line a new text buffer of iSize bytes, keeping its text
+  void ResizeText (CLineArena & TextArena, const int iSize);
+
+  // work out m_signature, once the line is finished
+  void Sign (const CLine * pPreviousLine);
+
+  // lines live in the world's line arena - use NewLine to make one
+  void * operator new (size_t nSize, CLineArena & arena) { return arena.Allocate (nSize); };
+  void operator delete (void * p, CLineArena &) { CLineArena::Free (p); };
+  void operator delete (void * p) { CLineArena::Free (p); };
+
+  };
+
+CLine * NewLine (const long nLineNumber, 
+                 const unsigned int nWrapColumn,
+                 const unsigned short iFlags,      
+                 const COLORREF       iForeColour,
+                 const COLORREF       iBackColour,
+                 const bool bUnicode,
+                 CLineArena & LineArena,
+                 CLineArena & TextArena);
+
+
+/*
+
+  CSendTemplate - send text (eg. "kill %1 with @weapon") broken up into a list
+  of items, so that expanding it (see CMUSHclientDoc::ExpandSendText) does not
+  have to parse it again each time.
+
+  Triggers and aliases keep one for their contents, which is parsed again only
+  if the contents, or whether to expand variables, has changed since.
+
+*/
+
+class CSendTemplate
+  {
+  public:
+
+  enum 
+    {
+    eLiteral,         // text copied as is
+    eWildcard,        // %1, or %<2>
+    eNamedWildcard,   // %<foo>
+    eVariable,        // @foo, or @!foo (empty name is an error)
+    eClipboard,       // %C
+    eName,            // %N
+    };
+
+  struct tItem
+    {
+    int     iType;      // see above
+    CString strText;    // literal text, wildcard name, or variable name (lower case)
+    int     iNumber;    // wildcard number
+    bool    bEscape;    // variable may be escaped (false for @!foo)
+    };
+
+  CSendTemplate () : m_iLiteralLength (0),
+                     m_bCompiled (false), 
+                     m_bExpandVariables (false), 
+                     m_bExpandWildcards (false) {};
+
+  // parse strText (which is strSource after any fixing up)
+  void Compile (const CString & strSource,
+                const CString & strText,
+                const bool bExpandVariables,
+                const bool bExpandWildcards);
+
+  // parse trigger or alias contents, unless already done
+  void Update (const CString & strContents, const bool bExpandVariables);
+
+  vector<tItem> m_vItems;
+  int m_iLiteralLength;     // total length of literal text (for preallocating)
+
+  private:
+
+  void AddLiteral (const char * pText, const int iLength);
+
+  CString m_strSource;      // what we compiled
+  bool m_bCompiled;
+  bool m_bExpandVariables;
+  bool m_bExpandWildcards;
+
   };
 
-typedef CTypedPtrList <CPtrList, CLine*> CLineList;
 
 /////////////////////////////////////////////////////////////////////////////
 //  CAlias
@@ -366,6 +463,7 @@ class CAlias : public CObject
    bOmitFromOutput = FALSE;
    bRegexp = FALSE;
    regexp = NULL;
+   bCompilePending = false;
    iSequence = DEFAULT_ALIAS_SEQUENCE;
    bKeepEvaluating = FALSE;
 
@@ -436,12 +534,14 @@ class CAlias : public CObject
   long  nMatched;         // how many times the alias matched
   vector<string> wildcards;   // matching wildcards
   t_regexp * regexp;      // compiled regular expression, if needed
+  bool bCompilePending;   // regexp not compiled yet (deferred when loaded)
   CTime tWhenMatched;     // when last matched
   bool bTemporary;        // if true, don't save it
   bool bIncluded;       // if true, don't save it
   bool bSelected;       // if true, selected for use in a plugin
   bool bExecutingScript;    // if true, executing a script and cannot be deleted
   CString strInternalName;  // name it is stored in the alias map under
+  CSendTemplate SendTemplate; // contents, parsed for expanding
   };
 
 // map for lookup by name
@@ -485,6 +585,7 @@ class CTrigger : public CObject
      bRegexp = false;
      bRepeat = false;
      regexp = NULL;
+     bCompilePending = false;
      iSequence = DEFAULT_TRIGGER_SEQUENCE;
      iMatch = 0;
      iStyle = 0;
@@ -503,6 +604,8 @@ class CTrigger : public CObject
      wildcards.resize (MAX_WILDCARDS);
      bExecutingScript = false;
      bOneShot = FALSE;
+     iExpandedRegexpSerial = 0;
+     bMatchNeedsExpanding = true;
 
     };
 
@@ -573,12 +676,17 @@ class CTrigger : public CObject
   long  nMatched;         // how many times the trigger fired
   vector<string> wildcards;   // matching wildcards
   t_regexp * regexp;      // compiled regular expression, if needed
+  bool bCompilePending;   // regexp not compiled yet (deferred when loaded)
   CTime tWhenMatched;     // when last matched
   bool bTemporary;        // if true, don't save it
   bool bIncluded;       // if true, don't save it
   bool bSelected;       // if true, selected for use in a plugin
   bool bExecutingScript;    // if true, executing a script and cannot be deleted
   CString strInternalName;  // name it is stored in the trigger map under
+  CString strExpandedMatch;   // match text after variable expansion (if bExpandVariables)
+  unsigned long iExpandedRegexpSerial;  // serial number of regexp compiled from strExpandedMatch
+  bool bMatchNeedsExpanding;  // a variable used in the match text has changed
+  CSendTemplate SendTemplate; // contents, parsed for expanding
   };
 
 // map for lookup by name
@@ -634,8 +742,12 @@ class CTimer : public CObject
      bOmitFromOutput = false;
      bOmitFromLog = false;
      bExecutingScript = false;
+     nCreateSequence = nNextCreateSequence++;
+     GetAllTimers () [nCreateSequence] = this;  // see FindTimer
     };
 
+  ~CTimer () { GetAllTimers ().erase (nCreateSequence); };
+
   bool operator== (const CTimer & rhs) const;
 
   int iType;             // at or interval, see enum above
@@ -699,8 +811,12 @@ class CTimer : public CObject
 
   static unsigned long GetNextTimerSequence () { return nNextCreateSequence++; }
 
+  // finds a timer from its nCreateSequence, or NULL if it has been deleted
+  static CTimer * FindTimer (const unsigned long nSequence);
+
   private:
     static unsigned long nNextCreateSequence;
+    static map<unsigned long, CTimer *> & GetAllTimers (void);
 
   };
 
@@ -709,6 +825,62 @@ typedef CTypedPtrMap <CMapStringToPtr, CString, CTimer*> CTimerMap;
 // map for lookup name from pointer
 typedef map <CTimer*, string> CTimerRevMap;
 
+/*
+
+  CTimerQueue - which timers are due next, so CheckTimerList does not have to
+  look at every timer on every tick.
+
+  It is a min-heap of (fire time, timer) entries. When a timer's fire time
+  changes, or it is enabled, it is simply scheduled again. Old entries are not
+  removed - when they reach the top of the heap they are discarded if the timer
+  has gone, is disabled, or is now due at some other time.
+
+*/
+
+class CTimerQueue
+  {
+  public:
+
+  CTimerQueue () : m_bRebuild (true) {};
+
+  // note that this timer is due at its tFireTime
+  void Schedule (const CTimer * pTimer);
+
+  // removes the next entry due by tNow, returning its timer if still valid
+  //  - returns false when nothing more is due
+  bool GetDue (const CmcDateTime & tNow, CTimer * & pTimer);
+
+  // puts a due timer aside until we are connected (see bActiveWhenClosed)
+  void Defer (const CTimer * pTimer);
+
+  // puts deferred timers back in the queue
+  void Undefer (void);
+
+  // schedule every enabled timer in the map again, from scratch
+  void Rebuild (CTimerMap & TimerMap);
+  bool NeedsRebuild (const CTimerMap & TimerMap) const
+    { return m_bRebuild || m_vHeap.size () > (TimerMap.GetCount () * 2) + 100; };
+  void SetRebuild (void) { m_bRebuild = true; };
+
+  int GetSize (void) const { return m_vHeap.size (); };
+
+  private:
+
+  struct tEntry
+    {
+    double dFireTime;           // tFireTime when scheduled
+    unsigned long nSequence;    // which timer (see CTimer::FindTimer)
+
+    // for a min-heap
+    bool operator< (const tEntry & rhs) const { return dFireTime > rhs.dFireTime; };
+    };
+
+  vector<tEntry> m_vHeap;       // soonest at the front
+  vector<tEntry> m_vDeferred;   // due, but waiting for a connection
+  bool m_bRebuild;              // true if we need to rebuild from the map
+
+  };
+
 
 /////////////////////////////////////////////////////////////////////////////
 //  CVariable
@@ -737,6 +909,10 @@ class CVariable : public CObject
 typedef CTypedPtrMap <CMapStringToPtr, CString, CVariable*> CVariableMap;
 typedef CTypedPtrArray <CPtrArray, CVariable*> CVariableArray;
 
+// variable name (lower-case) to the internal names of the triggers whose
+// match text uses it - so we only expand them again when the variable changes
+typedef map<string, set<string> > CVariableDependencyMap;
+
 /////////////////////////////////////////////////////////////////////////////
 //  CMud - not used?
 
@@ -894,6 +1070,74 @@ class CColours : public CObject
 typedef CTypedPtrMap <CMapStringToPtr, CString, CColours*> CColoursMap;
 
 
+/*
+
+  CEntityTable - MXP entity names and what they expand to
+
+  An open-addressing hash table, so that looking up &name; hashes the name where
+  it lies, without copying it or making a lower-case version of it first.
+
+  The inbuilt entities (eg. &lt; ) are case-sensitive, and once loaded the table
+  is made "perfect" - reseeded until every name sits in the slot it hashes to, so
+  a lookup is one hash and one compare.
+
+  Custom entities (<!ENTITY> and SetEntity) are stored with the key given, like
+  CMapStringToString, but hashed case-insensitively so that FindLower can match
+  the name as MXP supplied it against the lower-case names MXP stores.
+
+*/
+
+class CEntityTable
+  {
+  public:
+
+  struct tEntity
+    {
+    CString strName;      // entity name, eg. "lt" (empty if slot never used)
+    CString strValue;     // what it expands to, eg. "<"
+    long    iCharacter;   // for a single character, its code point (otherwise -1)
+    bool    bDeleted;     // slot was used, but entity has gone
+
+    tEntity () : iCharacter (-1), bDeleted (false) {};
+    };
+
+  CEntityTable (const bool bFoldCase = false) : m_bFoldCase (bFoldCase), 
+                                        m_iCount (0), 
+                                        m_iUsed (0), 
+                                        m_iSeed (0) {};
+
+  void SetAt (const CString & strName, const CString & strValue, const long iCharacter = -1);
+  void RemoveKey (const CString & strName);
+  void RemoveAll (void);
+
+  // exact match on the name, NULL if not there
+  const tEntity * Find (const char * sName, const int iLength) const;
+  // name matched as if it were in lower case (only if folding case), NULL if not there
+  const tEntity * FindLower (const char * sName, const int iLength) const;
+
+  // reseed (and grow if needed) until no name collides with another - for tables which
+  //  do not change once loaded
+  void MakePerfect (void);
+
+  int GetCount (void) const { return m_iCount; };
+
+  private:
+
+  unsigned long Hash (const char * sName, const int iLength) const;
+  void Rehash (const unsigned long iSize);
+  void Insert (const tEntity & entity);   // name known not to be there yet
+  // slot holding this name (compared in lower case if bLower), or -1
+  int Search (const char * sName, const int iLength, const bool bLower) const;
+
+  vector<tEntity> m_vSlots;   // size is a power of 2
+  bool m_bFoldCase;           // hash ignores case
+  int m_iCount;               // entities in table
+  int m_iUsed;                // slots in use, including deleted ones
+  unsigned long m_iSeed;      // starting value for the hash
+
+  };
+
+
 
 /////////////////////////////////////////////////////////////////////////////
 //  CActiveTag - these are outstanding (unclosed) tags
@@ -741,10 +741,6 @@ assemble the full text of the original line.
   // delete all lines in this set
     for (pos = m_LineList.GetTailPosition (); pos; )
      {
-     // if this particular line was added to the line positions array, then make it null
-      if (m_LineList.GetCount () % JUMP_SIZE == 1)
-            m_pLinePositions [m_LineList.GetCount () / JUMP_SIZE] = NULL;
-
       // version 4.54 - keep notes, even if omitted from output ;)
       // version 4.72 - also player input
 
@@ -788,7 +784,7 @@ assemble the full text of the original line.
       // if this was the first line, we have done enough
       if (pos == prevpos)
         break;    
-     m_LineList.GetPrev (pos);
+     pos = m_LineList.GetTailPosition ();   // the one before is now the tail
      }
 
     // try to allow world.tells to span omitted lines
@@ -798,6 +794,8 @@ assemble the full text of the original line.
       if (((m_pCurrentLine->flags & COMMENT) == 0) ||
           m_pCurrentLine->hard_return)
           m_pCurrentLine = NULL;
+      else
+        m_pCurrentLine->m_signature.SetAll ();   // it isn't finished after all
       }
     else
       m_pCurrentLine = NULL;
@@ -805,16 +803,15 @@ assemble the full text of the original line.
     if (!m_pCurrentLine)
       {
       // restart with a blank line at the end of the list
-      m_pCurrentLine = new CLine (++m_total_lines, 
-                                  m_nWrapColumn,
-                                  m_iFlags,
-                                  m_iForeColour,
-                                  m_iBackColour,
-                                  m_bUTF_8);
-      pos = m_LineList.AddTail (m_pCurrentLine);
-
-      if (m_LineList.GetCount () % JUMP_SIZE == 1)
-        m_pLinePositions [m_LineList.GetCount () / JUMP_SIZE] = pos;
+      m_pCurrentLine = NewLine (++m_total_lines, 
+                                m_nWrapColumn,
+                                m_iFlags,
+                                m_iForeColour,
+                                m_iBackColour,
+                                m_bUTF_8,
+                                m_LineArena,
+                                m_TextArena);
+      m_LineList.AddTail (m_pCurrentLine);
       }
 
     }
@@ -1009,13 +1006,20 @@ int iStartCol,
     iEndCol;
 POSITION pos;
 
+  // scan the line once for the literal text the triggers need
+  CTriggerPrefilter & prefilter = GetTriggerPrefilter ();
+  if (!prefilter.IsValid ())
+    prefilter.Build (GetTriggerArray ());
+  unsigned long iPrefilterScan = prefilter.Scan (strCurrentLine, strCurrentLine.GetLength ());
+
   for (iItem = 0; iItem < GetTriggerArray ().GetSize (); iItem++)
     {
     trigger_item = EvaluateTrigger (strCurrentLine, 
                                         strResponse,
                                         iItem,
                                         iStartCol,
-                                        iEndCol);
+                                        iEndCol,
+                                        iPrefilterScan);
     if (trigger_item)
       {  
 
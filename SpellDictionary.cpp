@@ -0,0 +1,458 @@
+// SpellDictionary.cpp - in-memory word list for the spell checker
+
+// See SpellDictionary.h for an explanation.
+
+#include "stdafx.h"
+#include "MUSHclient.h"
+#include "dmetaph.h"
+
+#include <sys/stat.h>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char BASED_CODE THIS_FILE[] = __FILE__;
+#endif
+
+#define IMAGE_MAGIC "SPELLDIC"
+#define IMAGE_VERSION 1
+
+// words longer than this are only compared (for edit distance) on this many
+// characters, which is already more than EditDistance looks at
+#define MAX_COMPARE_LENGTH 64
+
+// FNV-1a hash, upper-casing as we go if wanted
+
+static unsigned long HashString (const char * p, const bool bUpper)
+  {
+unsigned long iHash = 2166136261UL;
+
+  for ( ; *p; p++)
+    {
+    unsigned char c = (unsigned char) *p;
+    if (bUpper)
+      c = toupper (c);
+    iHash = (iHash ^ c) * 16777619UL;
+    }
+
+  return iHash;
+  } // end of HashString
+
+// compare two words, the way spellchecker.lua's make_upper used to
+
+static bool SameWord (const char * p1, const char * p2, const bool bCaseSensitive)
+  {
+  if (bCaseSensitive)
+    return strcmp (p1, p2) == 0;
+
+  for ( ; *p1 && *p2; p1++, p2++)
+    if (toupper ((unsigned char) *p1) != toupper ((unsigned char) *p2))
+      return false;
+
+  return *p1 == *p2;
+  } // end of SameWord
+
+// copy a word for comparison, upper-cased unless case-sensitive - returns its length
+
+static int CompareForm (const char * sWord, const bool bCaseSensitive, char * sBuffer)
+  {
+int i;
+
+  for (i = 0; sWord [i] && i < MAX_COMPARE_LENGTH; i++)
+    {
+    if (bCaseSensitive)
+      sBuffer [i] = sWord [i];
+    else
+      sBuffer [i] = toupper ((unsigned char) sWord [i]);
+    }
+
+  sBuffer [i] = 0;
+  return i;
+  } // end of CompareForm
+
+static time_t FileTime (const string & strFileName)
+  {
+struct _stat status;
+
+  if (_stat (strFileName.c_str (), &status) != 0)
+    return 0;
+
+  return status.st_mtime;
+  } // end of FileTime
+
+void CSpellDictionary::Clear (void)
+  {
+  m_vText.clear ();
+  m_vEntries.clear ();
+  m_strImage.erase ();
+  Rehash ();
+  } // end of CSpellDictionary::Clear
+
+bool CSpellDictionary::Load (const vector<string> & vFiles,
+                             const string & strImage,
+                             const int iMetaphoneLength,
+                             bool & bFromImage,
+                             string & strError)
+  {
+vector<string>::const_iterator it;
+
+  Clear ();
+  m_iMetaphoneLength = iMetaphoneLength;
+  bFromImage = false;
+
+  // the image is only any good if it was written after every word list changed
+  time_t tImage = FileTime (strImage);
+  bool bImageCurrent = tImage != 0;
+
+  for (it = vFiles.begin (); bImageCurrent && it != vFiles.end (); it++)
+    if (FileTime (*it) > tImage)
+      bImageCurrent = false;
+
+  if (bImageCurrent && LoadImage (strImage))
+    {
+    m_strImage = strImage;
+    bFromImage = true;
+    return true;
+    }
+
+  // do it the slow way
+  Clear ();
+
+  for (it = vFiles.begin (); it != vFiles.end (); it++)
+    if (!AddWordList (*it))
+      {
+      strError = "Cannot read dictionary " + *it;
+      Clear ();
+      return false;
+      }
+
+  // not being able to write the image just means we load slowly next time
+  if (SaveImage (strImage))
+    m_strImage = strImage;
+
+  return true;
+  } // end of CSpellDictionary::Load
+
+void CSpellDictionary::AddUserWord (const char * sWord)
+  {
+  AddWord (sWord, strlen (sWord));
+
+  if (!m_strImage.empty ())
+    SaveImage (m_strImage);
+
+  } // end of CSpellDictionary::AddUserWord
+
+bool CSpellDictionary::IsWord (const char * sWord, const bool bCaseSensitive) const
+  {
+long iEntry;
+
+  for (iEntry = m_vWordBucket [HashString (sWord, true) & m_iMask];
+       iEntry != -1;
+       iEntry = m_vWordNext [iEntry])
+    if (SameWord (Text (m_vEntries [iEntry].iWord), sWord, bCaseSensitive))
+      return true;
+
+  return false;
+  } // end of CSpellDictionary::IsWord
+
+// one possible replacement, as found by Suggest
+
+struct tSuggestion
+  {
+  int iDistance;        // edit distance from the word being checked
+  string strCompare;    // upper-cased, unless case-sensitive
+  const char * sWord;   // the word itself, in the dictionary text
+
+  bool operator< (const tSuggestion & rhs) const
+    {
+    if (iDistance != rhs.iDistance)
+      return iDistance < rhs.iDistance;
+    if (strCompare != rhs.strCompare)
+      return strCompare < rhs.strCompare;
+    return strcmp (sWord, rhs.sWord) < 0;
+    }
+  };
+
+void CSpellDictionary::Suggest (const char * sWord,
+                                const int iMaxDistance,
+                                const bool bCaseSensitive,
+                                vector<string> & vSuggestions) const
+  {
+vector<tSuggestion> vFound;
+char sTarget [MAX_COMPARE_LENGTH + 1];
+char sCandidate [MAX_COMPARE_LENGTH + 1];
+CString strMetaphone [2];
+int i;
+
+  vSuggestions.clear ();
+
+  const int iTargetLength = CompareForm (sWord, bCaseSensitive, sTarget);
+
+  MString m (sWord, m_iMetaphoneLength);
+  m.DoubleMetaphone (strMetaphone [0], strMetaphone [1]);
+
+  for (i = 0; i < 2; i++)
+    {
+    const char * sMetaphone = strMetaphone [i];
+
+    // no alternative, or the same as the first one
+    if (i == 1 && (strMetaphone [1].IsEmpty () || strMetaphone [1] == strMetaphone [0]))
+      break;
+
+    for (long iItem = m_vMetaphoneBucket [HashString (sMetaphone, false) & m_iMask];
+         iItem != -1;
+         iItem = m_vMetaphoneNext [iItem])
+      {
+      const tEntry & entry = m_vEntries [iItem >> 1];
+
+      if (strcmp (Text (entry.iMetaphone [iItem & 1]), sMetaphone) != 0)
+        continue;   // hash collision
+
+      const char * sDictWord = Text (entry.iWord);
+      const int iCandidateLength = CompareForm (sDictWord, bCaseSensitive, sCandidate);
+      const int iDistance = EditDistance (sCandidate, iCandidateLength,
+                                          sTarget, iTargetLength,
+                                          iMaxDistance);
+      if (iDistance >= iMaxDistance)
+        continue;   // not close enough
+
+      tSuggestion suggestion;
+      suggestion.iDistance = iDistance;
+      suggestion.sWord = sDictWord;
+      if (bCaseSensitive)
+        suggestion.strCompare = sDictWord;
+      else
+        {
+        suggestion.strCompare.resize (strlen (sDictWord));
+        for (string::size_type j = 0; j < suggestion.strCompare.size (); j++)
+          suggestion.strCompare [j] = toupper ((unsigned char) sDictWord [j]);
+        }
+      vFound.push_back (suggestion);
+      }   // end of each word with this metaphone hash
+    } // end of each metaphone
+
+  // best first - the same word may have been found under both metaphones, or be in
+  // more than one word list, but then it sorts next to itself
+  sort (vFound.begin (), vFound.end ());
+
+  for (vector<tSuggestion>::const_iterator it = vFound.begin (); it != vFound.end (); it++)
+    if (vSuggestions.empty () || vSuggestions.back () != it->sWord)
+      vSuggestions.push_back (it->sWord);
+
+  } // end of CSpellDictionary::Suggest
+
+long CSpellDictionary::AddText (const char * sText, const int iLength)
+  {
+  long iOffset = m_vText.size ();
+
+  m_vText.insert (m_vText.end (), sText, sText + iLength);
+  m_vText.push_back (0);
+
+  return iOffset;
+  } // end of CSpellDictionary::AddText
+
+void CSpellDictionary::AddWord (const char * sWord, const int iLength)
+  {
+  if (iLength == 0)
+    return;   // empty word
+
+  tEntry entry;
+
+  entry.iWord = AddText (sWord, iLength);
+
+  // get both metaphones (the word in the buffer is null-terminated)
+  MString m (Text (entry.iWord), m_iMetaphoneLength);
+  CString str1, str2;
+  m.DoubleMetaphone (str1, str2);
+
+  entry.iMetaphone [0] = AddText (str1, str1.GetLength ());
+  if (str2.IsEmpty ())
+    entry.iMetaphone [1] = -1;
+  else
+    entry.iMetaphone [1] = AddText (str2, str2.GetLength ());
+
+  m_vEntries.push_back (entry);
+
+  // keep the chains short
+  if (m_vEntries.size () > m_vWordBucket.size ())
+    Rehash ();
+  else
+    IndexEntry (m_vEntries.size () - 1);
+
+  } // end of CSpellDictionary::AddWord
+
+// read a word list - one word per line
+
+bool CSpellDictionary::AddWordList (const string & strFileName)
+  {
+  FILE * f = fopen (strFileName.c_str (), "rb");
+
+  if (!f)
+    return false;
+
+  vector<char> vBuffer;
+  char buf [4096];
+  size_t iCount;
+
+  while ((iCount = fread (buf, 1, sizeof buf, f)) > 0)
+    vBuffer.insert (vBuffer.end (), buf, buf + iCount);
+
+  bool bError = ferror (f) != 0;
+  fclose (f);
+
+  if (bError)
+    return false;
+
+  vBuffer.push_back ('\n');   // in case the last line isn't terminated
+
+  const char * p = &vBuffer [0];
+  const char * pEnd = p + vBuffer.size ();
+
+  while (p < pEnd)
+    {
+    const char * pEol = (const char *) memchr (p, '\n', pEnd - p);
+    const char * pLineEnd = pEol;
+
+    if (pLineEnd > p && pLineEnd [-1] == '\r')
+      pLineEnd--;
+
+    AddWord (p, pLineEnd - p);
+
+    p = pEol + 1;
+    }
+
+  return true;
+  } // end of CSpellDictionary::AddWordList
+
+bool CSpellDictionary::LoadImage (const string & strImage)
+  {
+tImageHeader header;
+bool bOK = false;
+
+  FILE * f = fopen (strImage.c_str (), "rb");
+
+  if (!f)
+    return false;
+
+  fseek (f, 0, SEEK_END);
+  const long iFileSize = ftell (f);
+  fseek (f, 0, SEEK_SET);
+
+  // the sizes in the header must add up to the file size
+  if (fread (&header, sizeof header, 1, f) == 1 &&
+      memcmp (header.sMagic, IMAGE_MAGIC, sizeof header.sMagic) == 0 &&
+      header.iVersion == IMAGE_VERSION &&
+      header.iMetaphoneLength == m_iMetaphoneLength &&
+      header.iEntries > 0 &&
+      header.iTextSize > 0 &&
+      header.iEntries <= (iFileSize - (long) sizeof header) / (long) sizeof (tEntry) &&
+      (long) sizeof header + header.iEntries * (long) sizeof (tEntry) + header.iTextSize == iFileSize)
+    {
+    m_vEntries.resize (header.iEntries);
+    m_vText.resize (header.iTextSize);
+
+    bOK = fread (&m_vEntries [0], sizeof (tEntry), header.iEntries, f) == (size_t) header.iEntries &&
+          fread (&m_vText [0], 1, header.iTextSize, f) == (size_t) header.iTextSize &&
+          m_vText.back () == 0;
+    }
+
+  fclose (f);
+
+  // make sure a damaged image can't send us outside the text
+  for (vector<tEntry>::const_iterator it = m_vEntries.begin ();
+       bOK && it != m_vEntries.end ();
+       it++)
+    if (it->iWord < 0 || it->iWord >= header.iTextSize ||
+        it->iMetaphone [0] < 0 || it->iMetaphone [0] >= header.iTextSize ||
+        it->iMetaphone [1] < -1 || it->iMetaphone [1] >= header.iTextSize)
+      bOK = false;
+
+  if (!bOK)
+    {
+    Clear ();
+    return false;
+    }
+
+  Rehash ();
+  return true;
+  } // end of CSpellDictionary::LoadImage
+
+bool CSpellDictionary::SaveImage (const string & strImage) const
+  {
+tImageHeader header;
+
+  if (m_vEntries.empty ())
+    return false;
+
+  memcpy (header.sMagic, IMAGE_MAGIC, sizeof header.sMagic);
+  header.iVersion = IMAGE_VERSION;
+  header.iMetaphoneLength = m_iMetaphoneLength;
+  header.iEntries = m_vEntries.size ();
+  header.iTextSize = m_vText.size ();
+
+  FILE * f = fopen (strImage.c_str (), "wb");
+
+  if (!f)
+    return false;
+
+  bool bOK = fwrite (&header, sizeof header, 1, f) == 1 &&
+             fwrite (&m_vEntries [0], sizeof (tEntry), m_vEntries.size (), f) == m_vEntries.size () &&
+             fwrite (&m_vText [0], 1, m_vText.size (), f) == m_vText.size ();
+
+  if (fclose (f) != 0)
+    bOK = false;
+
+  // don't leave a partial image around (LoadImage would reject it anyway)
+  if (!bOK)
+    remove (strImage.c_str ());
+
+  return bOK;
+  } // end of CSpellDictionary::SaveImage
+
+void CSpellDictionary::IndexEntry (const long iEntry)
+  {
+  const tEntry & entry = m_vEntries [iEntry];
+  unsigned long iBucket;
+  int i;
+
+  iBucket = HashString (Text (entry.iWord), true) & m_iMask;
+  m_vWordNext [iEntry] = m_vWordBucket [iBucket];
+  m_vWordBucket [iBucket] = iEntry;
+
+  for (i = 0; i < 2; i++)
+    {
+    if (entry.iMetaphone [i] == -1)
+      continue;
+
+    const long iItem = iEntry * 2 + i;
+    iBucket = HashString (Text (entry.iMetaphone [i]), false) & m_iMask;
+    m_vMetaphoneNext [iItem] = m_vMetaphoneBucket [iBucket];
+    m_vMetaphoneBucket [iBucket] = iItem;
+    }
+
+  } // end of CSpellDictionary::IndexEntry
+
+// size the buckets to the number of words (at least doubling), and rebuild the chains
+
+void CSpellDictionary::Rehash (void)
+  {
+unsigned long iBuckets = 1024;
+long iEntry;
+
+  while (iBuckets < m_vEntries.size () * 2)
+    iBuckets *= 2;
+
+  m_iMask = iBuckets - 1;
+
+  m_vWordBucket.assign (iBuckets, -1);
+  m_vMetaphoneBucket.assign (iBuckets, -1);
+
+  // room for words yet to come, so we don't have to keep growing these
+  m_vWordNext.assign (iBuckets, -1);
+  m_vMetaphoneNext.assign (iBuckets * 2, -1);
+
+  // add them back in the same order, so the chains are the same as before
+  for (iEntry = 0; iEntry < (long) m_vEntries.size (); iEntry++)
+    IndexEntry (iEntry);
+
+  } // end of CSpellDictionary::Rehash
@@ -0,0 +1,103 @@
+// SpellDictionary.h - in-memory word list for the spell checker
+
+#pragma once
+
+/*
+
+  This replaces the SQLite "words" table which spellchecker.lua used to build,
+  and query once per word being checked.
+
+  Every word is stored once in a single text buffer, followed by its one or two
+  double metaphones (all null-terminated), and a fixed-size entry per word gives
+  the offsets of those strings in the buffer. Two chained hash indexes sit over
+  the entries: one on the upper-cased word (is this a word?) and one on the
+  metaphones (which words sound like this one?). Adding a word therefore only
+  appends to three vectors, and a lookup does not allocate at all.
+
+  Suggestions are, as before, the words which share a metaphone with the word
+  being checked, and which are within the requested edit distance of it.
+
+  Working out the metaphones of the 50,000 or so dictionary words is what takes
+  the time, so once the word lists are loaded the text buffer and entries are
+  written out, as is, to an image file. Next time that is read back in two reads
+  (it only holds offsets, never pointers) and just the hash chains are rebuilt,
+  unless one of the word lists has been changed since the image was written.
+
+*/
+
+class CSpellDictionary
+  {
+  public:
+
+  CSpellDictionary () : m_iMetaphoneLength (4) { Clear (); };
+
+  // discard all words
+  void Clear (void);
+
+  // load from the image file if it is newer than all of the word lists, otherwise
+  // load the word lists and write a fresh image - returns false on error
+  bool Load (const vector<string> & vFiles,
+             const string & strImage,
+             const int iMetaphoneLength,
+             bool & bFromImage,
+             string & strError);
+
+  // add one word (eg. to the user dictionary), rewriting the image if we have one
+  void AddUserWord (const char * sWord);
+
+  // true if the word is in the dictionary
+  bool IsWord (const char * sWord, const bool bCaseSensitive) const;
+
+  // words sounding like this one, closer than iMaxDistance, best first
+  void Suggest (const char * sWord,
+                const int iMaxDistance,
+                const bool bCaseSensitive,
+                vector<string> & vSuggestions) const;
+
+  long GetCount (void) const { return (long) m_vEntries.size (); };
+
+  private:
+
+  // one per word - offsets into m_vText
+  struct tEntry
+    {
+    long iWord;             // the word itself
+    long iMetaphone [2];    // its metaphones, or -1 if it doesn't have a second one
+    };
+
+  // layout of the image file: header, then the entries, then the text
+  struct tImageHeader
+    {
+    char sMagic [8];          // SPELLDIC
+    long iVersion;            // IMAGE_VERSION
+    long iMetaphoneLength;    // metaphones must have been made the same way
+    long iEntries;            // number of tEntry which follow
+    long iTextSize;           // bytes of text which follow them
+    };
+
+  void AddWord (const char * sWord, const int iLength);
+  long AddText (const char * sText, const int iLength);
+  bool AddWordList (const string & strFileName);
+
+  bool LoadImage (const string & strImage);
+  bool SaveImage (const string & strImage) const;
+
+  // hash chains
+  void IndexEntry (const long iEntry);
+  void Rehash (void);
+
+  const char * Text (const long iOffset) const { return &m_vText [iOffset]; };
+
+  int m_iMetaphoneLength;           // passed to MString
+  string m_strImage;                // image file we loaded from or saved to
+
+  vector<char> m_vText;             // words and metaphones, each null-terminated
+  vector<tEntry> m_vEntries;        // one per word
+
+  unsigned long m_iMask;            // number of buckets - 1 (a power of 2 minus 1)
+  vector<long> m_vWordBucket;       // first entry for each hash of the upper-case word, or -1
+  vector<long> m_vWordNext;         // next entry in the same bucket, or -1
+  vector<long> m_vMetaphoneBucket;  // first entry * 2 + which metaphone, for each metaphone hash, or -1
+  vector<long> m_vMetaphoneNext;    // next (entry * 2 + which) in the same bucket, or -1
+
+  };
@@ -0,0 +1,47 @@
+// TextSignature.cpp - which trigrams a piece of text contains, for fast finding
+
+// See TextSignature.h for an explanation.
+
+#include "stdafx.h"
+#include "MUSHclient.h"
+#include "doc.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char BASED_CODE THIS_FILE[] = __FILE__;
+#endif
+
+void CTextSignature::Add (const char * sPrefix, const int iPrefixLength,
+                          const char * sText, const int iLength,
+                          const bool bASCIIOnly)
+  {
+unsigned long iWindow = 0;    // last three bytes seen
+int iCount = 0;               // how many bytes in the window are valid
+int iTotal = iPrefixLength + iLength;
+
+  for (int i = 0; i < iTotal; i++)
+    {
+    unsigned char c = i < iPrefixLength ? sPrefix [i] : sText [i - iPrefixLength];
+
+    // fold ASCII only - see ExtractRequiredLiteral
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+
+    if (bASCIIOnly && c >= 0x80)
+      {
+      iCount = 0;   // start again after it
+      continue;
+      }
+
+    iWindow = ((iWindow << 8) | c) & 0xFFFFFF;
+
+    if (++iCount < 3)
+      continue;   // not a whole trigram yet
+
+    // Fibonacci hashing - the top 8 bits select the bit in the signature
+    unsigned long iHash = ((iWindow * 2654435761UL) & 0xFFFFFFFF) >> 24;
+    m_iBits [iHash >> 5] |= 1UL << (iHash & 31);
+    } // end of for each byte
+
+  } // end of CTextSignature::Add
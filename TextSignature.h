@@ -0,0 +1,70 @@
+// TextSignature.h - which trigrams a piece of text contains, for fast finding
+
+#pragma once
+
+/*
+
+  Finding text in a large output buffer used to mean building a CString for
+  every paragraph and searching it (or running PCRE over it). With a big
+  scrollback "find again" could take seconds.
+
+  Now, as each line is finished (in StartNewLine), we note which three-byte
+  sequences (trigrams) are in it, by hashing each one to a bit in a 256-bit
+  signature. A trigram which spans a soft wrap belongs to the later line, so
+  the signatures of the lines in a paragraph, OR'ed together, cover every
+  trigram in the paragraph's text.
+
+  Text we are looking for gets a signature the same way. A paragraph cannot
+  contain it unless every bit in the wanted signature is also set in the
+  paragraph's signature, so most paragraphs can be skipped with a few
+  comparisons. Hash collisions only ever let extra paragraphs through, which
+  are then searched normally.
+
+  ASCII letters are folded to lower case, so one signature serves both case-
+  sensitive and case-insensitive searches. For regular expressions we use the
+  literal text every match must contain (see ExtractRequiredLiteral).
+
+  The signatures are kept in each CLine, so they go when the line does (eg. in
+  RemoveChunk). A line which has not been finished yet has all bits set, so it
+  is always searched.
+
+*/
+
+#define TEXT_SIGNATURE_WORDS 8    // 8 x 32 = 256 bits
+
+class CTextSignature
+  {
+  public:
+
+  CTextSignature () { SetAll (); };   // might contain anything
+
+  void Clear (void) { memset (m_iBits, 0, sizeof m_iBits); };
+  void SetAll (void) { memset (m_iBits, 0xFF, sizeof m_iBits); };
+
+  // add the trigrams in sText, which follows on from sPrefix (eg. the end of
+  // the previous line, if this one was wrapped)
+  //  - if bASCIIOnly, ignore trigrams with non-ASCII bytes (their case folding is unknown)
+  void Add (const char * sPrefix, const int iPrefixLength,
+            const char * sText, const int iLength,
+            const bool bASCIIOnly = false);
+
+  void Merge (const CTextSignature & other)
+    {
+    for (int i = 0; i < TEXT_SIGNATURE_WORDS; i++)
+      m_iBits [i] |= other.m_iBits [i];
+    };
+
+  // true if text with this signature might contain text with the other one
+  bool MightContain (const CTextSignature & other) const
+    {
+    for (int i = 0; i < TEXT_SIGNATURE_WORDS; i++)
+      if ((other.m_iBits [i] & ~m_iBits [i]) != 0)
+        return false;
+    return true;
+    };
+
+  private:
+
+  unsigned long m_iBits [TEXT_SIGNATURE_WORDS];
+
+  };
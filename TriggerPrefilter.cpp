@@ -0,0 +1,200 @@
+// TriggerPrefilter.cpp - multi-pattern prefilter for trigger evaluation
+
+// See TriggerPrefilter.h for an explanation.
+
+#include "stdafx.h"
+#include "MUSHclient.h"
+#include "doc.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char BASED_CODE THIS_FILE[] = __FILE__;
+#endif
+
+void CTriggerPrefilter::Build (const CTriggerArray & triggers)
+  {
+map<string, int> mapLiterals;   // literal to its index in vLiterals
+vector<string> vLiterals;       // distinct literals
+int i;
+
+  m_vEntries.resize (triggers.GetSize ());
+
+  // find what each trigger needs
+  for (i = 0; i < triggers.GetSize (); i++)
+    {
+    const CTrigger * trigger_item = triggers [i];
+    tEntry & entry = m_vEntries [i];
+
+    entry.pTrigger = trigger_item;
+    entry.iSerial = 0;
+    entry.iLiteral = -1;    // always a candidate
+
+    // multi-line triggers match on assembled text, and triggers with
+    // expanded variables are recompiled on every line - let them through
+    if (trigger_item->regexp == NULL ||
+        trigger_item->bMultiLine ||
+        trigger_item->bExpandVariables)
+      continue;
+
+    const string & sLiteral = trigger_item->regexp->m_sRequiredLiteral;
+
+    if (sLiteral.empty ())
+      continue;
+
+    entry.iSerial = trigger_item->regexp->m_iSerial;
+
+    map<string, int>::const_iterator it = mapLiterals.find (sLiteral);
+    if (it == mapLiterals.end ())
+      {
+      entry.iLiteral = vLiterals.size ();
+      mapLiterals [sLiteral] = entry.iLiteral;
+      vLiterals.push_back (sLiteral);
+      }
+    else
+      entry.iLiteral = it->second;
+    } // end of for each trigger
+
+  // work out byte classes - bytes not in any literal share class 0
+  memset (m_cClass, 0, sizeof m_cClass);
+  m_iClassCount = 1;
+
+  vector<string>::const_iterator lit;
+  string::const_iterator c;
+
+  for (lit = vLiterals.begin (); lit != vLiterals.end (); lit++)
+    for (c = lit->begin (); c != lit->end (); c++)
+      if (m_cClass [(unsigned char) *c] == 0)
+        m_cClass [(unsigned char) *c] = m_iClassCount++;
+
+  // literals are lower-case, so upper-case letters fold onto them
+  for (i = 'A'; i <= 'Z'; i++)
+    m_cClass [i] = m_cClass [i + 'a' - 'A'];
+
+  // build the trie - state 0 is the root
+  m_vDelta.assign (m_iClassCount, -1);
+  m_vOutput.assign (1, -1);
+
+  for (i = 0; i < vLiterals.size (); i++)
+    {
+    int iState = 0;
+    for (c = vLiterals [i].begin (); c != vLiterals [i].end (); c++)
+      {
+      int iClass = m_cClass [(unsigned char) *c];
+      int iNext = m_vDelta [iState * m_iClassCount + iClass];
+      if (iNext < 0)
+        {
+        iNext = m_vOutput.size ();
+        m_vDelta.resize (m_vDelta.size () + m_iClassCount, -1);
+        m_vOutput.push_back (-1);
+        m_vDelta [iState * m_iClassCount + iClass] = iNext;
+        }
+      iState = iNext;
+      }
+    m_vOutput [iState] = i;
+    } // end of adding each literal
+
+  // now turn it into a DFA, breadth-first, resolving failure links as we go
+  const int iStates = m_vOutput.size ();
+  vector<int> vFail (iStates, 0);
+  deque<int> queue;
+  int iClass;
+
+  m_vOutputLink.assign (iStates, 0);
+
+  for (iClass = 0; iClass < m_iClassCount; iClass++)
+    {
+    int iNext = m_vDelta [iClass];
+    if (iNext < 0)
+      m_vDelta [iClass] = 0;    // stay at the root
+    else
+      queue.push_back (iNext);
+    }
+
+  while (!queue.empty ())
+    {
+    int iState = queue.front ();
+    queue.pop_front ();
+
+    for (iClass = 0; iClass < m_iClassCount; iClass++)
+      {
+      int iNext = m_vDelta [iState * m_iClassCount + iClass];
+      int iFail = m_vDelta [vFail [iState] * m_iClassCount + iClass];
+      if (iNext < 0)
+        m_vDelta [iState * m_iClassCount + iClass] = iFail;
+      else
+        {
+        vFail [iNext] = iFail;
+        m_vOutputLink [iNext] = m_vOutput [iFail] >= 0 ? iFail : m_vOutputLink [iFail];
+        queue.push_back (iNext);
+        }
+      } // end of each class
+    } // end of processing queue
+
+  m_vStateSeen.assign (iStates, 0);
+  m_vLiteralSeen.assign (vLiterals.size (), 0);
+
+  m_bValid = true;
+  } // end of CTriggerPrefilter::Build
+
+unsigned long CTriggerPrefilter::Scan (const char * sText, const int iLength)
+  {
+  if (!m_bValid)
+    return 0;
+
+  m_iScanNumber++;
+
+  // nothing to look for?
+  if (m_vLiteralSeen.empty ())
+    return m_iScanNumber;
+
+  const unsigned char * p = (const unsigned char *) sText;
+  const unsigned char * pEnd = p + iLength;
+  const int * pDelta = &m_vDelta [0];
+  int iState = 0;
+
+  for ( ; p < pEnd; p++)
+    {
+    iState = pDelta [iState * m_iClassCount + m_cClass [*p]];
+
+    // note any literals ending here - once per state per line is enough
+    for (int iOut = iState;
+         iOut && m_vStateSeen [iOut] != m_iScanNumber;
+         iOut = m_vOutputLink [iOut])
+      {
+      m_vStateSeen [iOut] = m_iScanNumber;
+      if (m_vOutput [iOut] >= 0)
+        m_vLiteralSeen [m_vOutput [iOut]] = m_iScanNumber;
+      }
+    } // end of each byte
+
+  return m_iScanNumber;
+  } // end of CTriggerPrefilter::Scan
+
+bool CTriggerPrefilter::IsCandidate (const int iItem,
+                                     const CTrigger * pTrigger,
+                                     const unsigned long iScanNumber) const
+  {
+  // if we were rebuilt, or another line was scanned since (eg. a script
+  // did a Simulate), we can't say
+  if (!m_bValid ||
+      iScanNumber == 0 ||
+      iScanNumber != m_iScanNumber ||
+      iItem >= m_vEntries.size ())
+    return true;
+
+  const tEntry & entry = m_vEntries [iItem];
+
+  if (entry.iLiteral < 0)
+    return true;    // no literal known
+
+  // trigger changed since we were built? play safe
+  if (entry.pTrigger != pTrigger ||
+      pTrigger->regexp == NULL ||
+      pTrigger->regexp->m_iSerial != entry.iSerial ||
+      pTrigger->bMultiLine ||
+      pTrigger->bExpandVariables)
+    return true;
+
+  return m_vLiteralSeen [entry.iLiteral] == m_iScanNumber;
+  } // end of CTriggerPrefilter::IsCandidate
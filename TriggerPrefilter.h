@@ -0,0 +1,65 @@
+// TriggerPrefilter.h - multi-pattern prefilter for trigger evaluation
+
+#pragma once
+
+/*
+
+  Most triggers cannot possibly match unless some literal text appears in the
+  line, eg. "^You hit (.*?)$" needs "you hit ". That text is worked out when
+  the regular expression is compiled (see ExtractRequiredLiteral in regexp.cpp).
+
+  For each trigger array we build a single Aho-Corasick automaton from those
+  literals, scan each incoming line through it once, and then only hand to
+  PCRE the triggers whose literal was seen (or which have no literal at all).
+
+  The prefilter only ever answers "might match" or "cannot match", so trigger
+  sequence order and "keep evaluating" behaviour are unchanged. Whenever it is
+  in doubt (eg. the trigger changed after the automaton was built) it answers
+  "might match".
+
+*/
+
+class CTriggerPrefilter
+  {
+  public:
+
+  CTriggerPrefilter () : m_bValid (false), m_iScanNumber (0), m_iClassCount (1) {};
+
+  // call when the trigger array changes (eg. from SortTriggers)
+  void Invalidate (void) { m_bValid = false; };
+  bool IsValid (void) const { return m_bValid; };
+
+  // build the automaton from the triggers in this array
+  void Build (const CTriggerArray & triggers);
+
+  // scan a line, noting which literals are present - returns the scan number
+  unsigned long Scan (const char * sText, const int iLength);
+
+  // true if the trigger at this position in the array might match the line
+  // which was scanned as iScanNumber
+  bool IsCandidate (const int iItem,
+                    const CTrigger * pTrigger,
+                    const unsigned long iScanNumber) const;
+
+  private:
+
+  // what we knew about each trigger when the automaton was built
+  struct tEntry
+    {
+    const CTrigger * pTrigger;  // which trigger
+    unsigned long iSerial;      // serial number of its regexp
+    int iLiteral;               // which literal it needs, or -1 for none
+    };
+
+  bool m_bValid;                      // false if we need to rebuild
+  unsigned long m_iScanNumber;        // incremented for every line scanned
+  int m_iClassCount;                  // number of distinct byte classes
+  unsigned char m_cClass [256];       // maps a byte to its class (case-folded)
+  vector<tEntry> m_vEntries;          // one per trigger, in array order
+  vector<int> m_vDelta;               // transitions, indexed by state * m_iClassCount + class
+  vector<int> m_vOutput;              // literal which ends at each state, or -1
+  vector<int> m_vOutputLink;          // next state along failure chain with an output, or 0
+  vector<unsigned long> m_vStateSeen;     // scan number when state was last reported
+  vector<unsigned long> m_vLiteralSeen;   // scan number when literal was last found
+
+  };
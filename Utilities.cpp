@@ -2341,59 +2341,86 @@ int iChanges = 0;
 // Levenshtein Distance Algorithm
 // see: http://www.merriampark.com/ldcpp.htm
 
-int EditDistance (const std::string source, const std::string target) 
-  {
-
 // keep maximum down in case they feed in a ridiculously long word
 // runtime is proportional to O(mn)
 
-const int MAX_LENGTH = 20;
+static const int EDIT_DISTANCE_MAX_LENGTH = 20;
+
+int EditDistance (const std::string & source, const std::string & target) 
+  {
+  return EditDistance (source.c_str (), source.length (), 
+                       target.c_str (), target.length (), 
+                       INT_MAX);
+  }   // end of EditDistance
+
+// This version works on a fixed-size matrix on the stack, so it never allocates.
+
+// If iLimit is smaller than the real distance, iLimit is returned instead. Cells
+// further than iLimit from the diagonal are not computed (they can't be under it),
+// and we give up as soon as two successive rows are entirely at the limit, as no
+// later row can then come in under it.
+
+int EditDistance (const char * source, const size_t iSourceLength,
+                  const char * target, const size_t iTargetLength,
+                  int iLimit) 
+  {
+
+int matrix [EDIT_DISTANCE_MAX_LENGTH + 1] [EDIT_DISTANCE_MAX_LENGTH + 1];
+
+  // no distance can be larger than this, and it keeps i + iLimit from overflowing
+  if (iLimit > EDIT_DISTANCE_MAX_LENGTH + 1)
+    iLimit = EDIT_DISTANCE_MAX_LENGTH + 1;
 
   // Step 1
 
-  const int n = minimum<int> (source.length(), MAX_LENGTH);
-  const int m = minimum<int> (target.length(), MAX_LENGTH);
+  const int n = minimum<int> (iSourceLength, EDIT_DISTANCE_MAX_LENGTH);
+  const int m = minimum<int> (iTargetLength, EDIT_DISTANCE_MAX_LENGTH);
 
   int i, j;
 
   if (n == 0)
-      return m;
+      return min (m, iLimit);
 
   if (m == 0)
-      return n;
-  
-  // Good form to declare a TYPEDEF
-
-  typedef std::vector< std::vector<int> > Tmatrix; 
+      return min (n, iLimit);
 
-  Tmatrix matrix(n+1);
-
-  // Size the vectors in the 2.nd dimension. Unfortunately C++ doesn't
-  // allow for allocation on declaration of 2.nd dimension of vec of vec
-
-  for (i = 0; i <= n; i++) {
-    matrix[i].resize(m+1);
-  }
+  // the distance is at least the difference in lengths
+  if (abs (n - m) >= iLimit)
+    return iLimit;
 
   // Step 2
 
   for (i = 0; i <= n; i++) {
-    matrix[i][0]=i;
+    matrix[i][0]=min (i, iLimit);
   }
 
   for (j = 0; j <= m; j++) {
-    matrix[0][j]=j;
+    matrix[0][j]=min (j, iLimit);
   }
 
+  int previous_row_minimum = 0;
+
   // Step 3
 
   for (i = 1; i <= n; i++) {
 
     const char s_i = source[i-1];
 
+    // only cells within iLimit of the diagonal can be under the limit
+    const int first = max (1, i - iLimit);
+    const int last = min (m, i + iLimit);
+
+    // cells just outside the band are read by this row and the next one
+    if (first > 1)
+      matrix[i][first-1] = iLimit;
+    if (last < m)
+      matrix[i][last+1] = iLimit;
+
+    int row_minimum = matrix[i][first-1];
+
     // Step 4
 
-    for (j = 1; j <= m; j++) {
+    for (j = first; j <= last; j++) {
 
       const char t_j = target[j-1];
 
@@ -2427,8 +2454,21 @@ const int MAX_LENGTH = 20;
         if (cell>trans) cell=trans;
       }
 
+      if (cell > iLimit)
+        cell = iLimit;
+
       matrix[i][j]=cell;
+
+      if (cell < row_minimum)
+        row_minimum = cell;
     }
+
+    // a cell is at least the smaller of the row above, or 1 more than the row
+    // above that (transposition) - so if both rows are at the limit, we are done
+    if (row_minimum >= iLimit && previous_row_minimum >= iLimit)
+      return iLimit;
+
+    previous_row_minimum = row_minimum;
   }
 
   // Step 7
@@ -28,6 +28,8 @@ CChatSocket::CChatSocket(CMUSHclientDoc* pDoc)
 {
 	m_pDoc = pDoc;
   m_hNameLookup = NULL;
+  m_iOutputSent = 0;
+  m_iInputUsed = 0;
   m_pGetHostStruct = NULL;
   ZeroMemory (&m_ServerAddr, sizeof m_ServerAddr);
   m_bDeleteMe = false;  
@@ -80,6 +82,7 @@ CChatSocket::CChatSocket(CMUSHclientDoc* pDoc)
   m_iFileSize = 0;           
   m_iFileBlocks = 0;         
   m_iBlocksTransferred = 0;  
+  m_iBlocksRequested = 0;
   m_pFile = NULL;  
   m_pFileBuffer = NULL;
   m_tStartedFileTransfer = 0;
@@ -161,9 +164,39 @@ void CChatSocket::StopFileTransfer (const bool bAbort)
   m_iFileSize = 0;           
   m_iFileBlocks = 0;         
   m_iBlocksTransferred = 0;  
+  m_iBlocksRequested = 0;
   m_tStartedFileTransfer = 0;
 
-  } // end of CChatSocket::StopFileTransfer 
+  } // end of CChatSocket::StopFileTransfer
+
+// Ask the sender for more file blocks. 
+
+// The protocol is one block per request, and originally we asked for the next
+// block when each one arrived, so a file took (blocks x round trip time) to transfer.
+// A MUSHclient sender simply answers each request as it arrives, so for those
+// we keep CHAT_FILE_BLOCKS_IN_FLIGHT requests outstanding, and never ask for more
+// blocks than there are. Other clients get the original one-at-a-time behaviour.
+
+void CChatSocket::RequestFileBlocks (void)
+  {
+
+  if (m_strRemoteVersion.Left (10) != "MUSHclient")
+    {
+    // get next block - even if at end - see MudMaster
+    SendChatMessage (CHAT_FILE_BLOCK_REQUEST, "");
+    m_iBlocksRequested++;
+    return;
+    }
+
+  // always ask at least once (the sender handles empty files)
+  while ((m_iBlocksRequested < m_iFileBlocks || m_iBlocksRequested == 0) &&
+         m_iBlocksRequested < m_iBlocksTransferred + CHAT_FILE_BLOCKS_IN_FLIGHT)
+    {
+    SendChatMessage (CHAT_FILE_BLOCK_REQUEST, "");
+    m_iBlocksRequested++;
+    }
+
+  } // end of CChatSocket::RequestFileBlocks 
 
 
 void CChatSocket::OnReceive(int nErrorCode)
@@ -395,10 +428,25 @@ int count = Receive (buff, sizeof (buff) - 1);
 
 // now take the incoming text and break into blocks
 
+  // Messages are taken from the front of the buffer by advancing m_iInputUsed, 
+  // rather than copying everything after each one (which gets slow for a large
+  // snoop or file transfer). What we have used is discarded here, once per packet.
+
+  // m_iInputUsed is a member (and is advanced before processing each message), 
+  // in case processing a message lets us be called again (eg. a dialog box)
+
+  if (m_iInputUsed > 0)
+    {
+    m_outstanding_input.Delete (0, m_iInputUsed);
+    m_iInputUsed = 0;
+    }
+
   m_outstanding_input += CString (buff, count); // add to any left over
 
-  while (!m_bDeleteMe && !m_outstanding_input.IsEmpty ())
+  while (!m_bDeleteMe && m_iInputUsed < m_outstanding_input.GetLength ())
     {
+    const unsigned char * p = (const unsigned char *) (LPCTSTR) m_outstanding_input + m_iInputUsed;
+    int iAvailable = m_outstanding_input.GetLength () - m_iInputUsed;
 
     switch (m_iChatConnectionType)
       {
@@ -407,20 +455,19 @@ int count = Receive (buff, sizeof (buff) - 1);
         {
         // file blocks are fixed length and might contain nulls
 
-        if (m_outstanding_input [0] == CHAT_FILE_BLOCK)
+        if (p [0] == CHAT_FILE_BLOCK)
           {
-          int iLength = m_outstanding_input.GetLength ();
 
           // must have file block size + 2 (command and terminator)
           // otherwise we will get them later
-          if (iLength < (m_iFileBlockSize + 2))
+          if (iAvailable < (m_iFileBlockSize + 2))
             return;
 
           // make a buffer of exactly the file data
-          CString strBuffer = m_outstanding_input.Mid (1, m_iFileBlockSize);
+          CString strBuffer ((LPCTSTR) &p [1], m_iFileBlockSize);
 
           // discard the file block and message number and terminator byte
-          m_outstanding_input = m_outstanding_input.Mid (m_iFileBlockSize + 2);
+          m_iInputUsed += m_iFileBlockSize + 2;
 
           // now process the incoming file block
           ProcessChatMessage (CHAT_FILE_BLOCK, strBuffer);
@@ -429,38 +476,46 @@ int count = Receive (buff, sizeof (buff) - 1);
         else
           {   // not a file block - use variable-length terminator
 
-          int iTerminator = m_outstanding_input.Find ((char) CHAT_END_OF_COMMAND);
+          const unsigned char * pTerminator = 
+              (const unsigned char *) memchr (p, CHAT_END_OF_COMMAND, iAvailable);
 
           // if no terminator, wait for one to arrive in the next packet
-          if (iTerminator == -1)
+          if (pTerminator == NULL)
             return;   
 
-          CString strChatMessage = m_outstanding_input.Left (iTerminator);
-          m_outstanding_input = m_outstanding_input.Mid (iTerminator + 1);
+          int iTerminator = pTerminator - p;
+          int iCommand = 0;
+          CString strChatMessage;
+
+          // first byte is the command, the rest is the message
+          if (iTerminator > 0)
+            {
+            iCommand = p [0];
+            strChatMessage = CString ((LPCTSTR) &p [1], iTerminator - 1);
+            }
+
+          m_iInputUsed += iTerminator + 1;
 
-          ProcessChatMessage ((unsigned char) strChatMessage [0], strChatMessage.Mid (1));
+          ProcessChatMessage (iCommand, strChatMessage);
           }   // end of not file block
         } // end of MudMaster chat type
         break;
 
       case eChatZMud:
         {
-        int iInputLength = m_outstanding_input.GetLength ();
         // must have 4 bytes (command:2, and length:2) or we cannot have a packet
-        if (iInputLength < 4)
+        if (iAvailable < 4)
           return;    // wait for them
 
-        int iCommand = (int) (unsigned char) m_outstanding_input [0] |
-                       (((int) (unsigned char) m_outstanding_input [1]) << 8);
+        int iCommand = (int) p [0] | (((int) p [1]) << 8);
 
-        int iLength = (int) (unsigned char) m_outstanding_input [2] |
-                       (((int) (unsigned char) m_outstanding_input [3]) << 8);
+        int iLength = (int) p [2] | (((int) p [3]) << 8);
 
-        if (iInputLength < (iLength + 4))
+        if (iAvailable < (iLength + 4))
           return;   // whole block has not arrived yet
 
-        CString strChatMessage = m_outstanding_input.Mid (4, iLength);
-        m_outstanding_input = m_outstanding_input.Mid (iLength + 4);
+        CString strChatMessage ((LPCTSTR) &p [4], iLength);
+        m_iInputUsed += iLength + 4;
 
         ProcessChatMessage (iCommand, strChatMessage);
 
@@ -487,16 +542,25 @@ int count;
 
 // if we have outstanding data to send, do it
 
-  if (m_outstanding_output.GetLength () <= 0)
+  if (m_outstanding_output.GetLength () <= m_iOutputSent)
     return;
 
-  count = Send (m_outstanding_output, m_outstanding_output.GetLength ());
+  count = Send ((LPCTSTR) m_outstanding_output + m_iOutputSent, 
+                m_outstanding_output.GetLength () - m_iOutputSent);
 
   if (count != SOCKET_ERROR)
     m_pDoc->m_nBytesOut += count; // count bytes out
 
   if (count > 0)    // good send - do rest later
-    m_outstanding_output = m_outstanding_output.Mid (count);
+    {
+    m_iOutputSent += count;
+    // all gone? start again with an empty buffer
+    if (m_iOutputSent >= m_outstanding_output.GetLength ())
+      {
+      m_outstanding_output.Empty ();
+      m_iOutputSent = 0;
+      }
+    }
   else
     {
     int nError = GetLastError ();
@@ -509,6 +573,7 @@ int count;
                       m_pDoc->GetSocketError (nError)));
       ShutDownSocket (*this);
       m_outstanding_output.Empty ();
+      m_iOutputSent = 0;
       OnClose (nError);      // ????
       }   // end of an error other than "would block"
     } // end of an error
@@ -661,6 +726,13 @@ void CChatSocket::SendData (const CString & strText)
 
   m_tLastOutgoing = CTime::GetCurrentTime();
 
+  // if most of the buffer has been sent, discard that part before adding more
+  if (m_iOutputSent > 0 && m_iOutputSent >= m_outstanding_output.GetLength () / 2)
+    {
+    m_outstanding_output.Delete (0, m_iOutputSent);
+    m_iOutputSent = 0;
+    }
+
   m_outstanding_output += strText;
 
   OnSend (0);   // in case FD_WRITE message got lost, try to send again
@@ -1135,9 +1207,6 @@ void CChatSocket::Process_File_start				  (const CString strMessage)
     return;
     } // end of catching a file exception
 
-  // tell them our acceptance - get first block
-  SendChatMessage (CHAT_FILE_BLOCK_REQUEST, "");
-
   m_pDoc->ChatNote (eChatFile,
               TFormat (
         "Receiving a file from %s -- Filename: %s, Length: %ld bytes (%1.1f Kb).",
@@ -1154,9 +1223,13 @@ void CChatSocket::Process_File_start				  (const CString strMessage)
   // add block-size minus one to allow for final partial block
   m_iFileBlocks = (m_iFileSize + m_iFileBlockSize - 1L) /
                   m_iFileBlockSize;
+  m_iBlocksRequested = 0;
 
   shsInit  (&m_shsInfo);
 
+  // tell them our acceptance - get first block(s)
+  RequestFileBlocks ();
+
   } // end of CChatSocket::Process_File_start
 
 void CChatSocket::Process_File_deny				    (const CString strMessage)
@@ -1296,8 +1369,8 @@ void CChatSocket::Process_File_block			    (const CString strMessage)
   strBuffer.ReleaseBuffer ();
   m_iCountFileBytesIn += expected;
 
-  // get next block - even if at end - see MudMaster
-  SendChatMessage (CHAT_FILE_BLOCK_REQUEST, "");
+  // get next block(s)
+  RequestFileBlocks ();
 
   if (m_iBlocksTransferred >= m_iFileBlocks)
     {
@@ -10,6 +10,10 @@ class CMUSHclientDoc;
 // in this time interval, discard the second one (if addressed to all or a group)
 #define LOOP_DISCARD_SAME_MESSAGE_SECONDS 5
 
+// when receiving a file from another MUSHclient, how many blocks we ask for 
+// before the first one arrives (otherwise it is one request per round trip)
+#define CHAT_FILE_BLOCKS_IN_FLIGHT 16
+
 // MudMaster Chat Message Codes
 
 #define CHAT_NAME_CHANGE				   1
@@ -107,7 +111,9 @@ public:
 public:
 	CMUSHclientDoc* m_pDoc;
   CString m_outstanding_output;   // stuff we have yet to send them
+  int     m_iOutputSent;          // how much of m_outstanding_output has been sent
   CString m_outstanding_input;    // input not yet processed (eg. no \xFF yet)
+  int     m_iInputUsed;           // how much of m_outstanding_input has been processed
 
   CString m_strServerName;       // server name before DNS resolution
 	SOCKADDR_IN m_ServerAddr;      // Chat server address/port
@@ -157,6 +163,7 @@ public:
   long m_iFileSize;               // bytes in file
   long m_iFileBlocks;             // total blocks in file
   long m_iBlocksTransferred;      // how many we sent/received so far
+  long m_iBlocksRequested;        // how many we asked for so far (receiving)
   CFile * m_pFile;                // open file we are sending/saving
   CTime m_tStartedFileTransfer;   // when file send/receive started
   long m_iFileBlockSize;          // size of file block
@@ -193,6 +200,7 @@ public:
                         const CString strMessage, 
                         const long iStamp = 0);
   void StopFileTransfer (const bool bAbort);
+  void RequestFileBlocks (void);
 
   long GetStamp (CString & strMessage);    // extracts message stamp
 
@@ -1589,29 +1589,12 @@ void CMUSHclientDoc:: SavePrefsP14 (CPrefsP14 &page14)
 
   if (m_pCurrentLine)     // a new world might not have a line yet
     {
-    // save current line text
-    CString strLine = CString (m_pCurrentLine->text, m_pCurrentLine->len);
-
     if (m_bUTF_8)
-      m_pCurrentLine->iMemoryAllocated = MAX ((UINT) m_pCurrentLine->len, page14.m_nWrapColumn) * 4;
+      m_pCurrentLine->ResizeText (m_TextArena, 
+                                  MAX ((UINT) m_pCurrentLine->len, page14.m_nWrapColumn) * 4);
     else
-      m_pCurrentLine->iMemoryAllocated = MAX ((UINT) m_pCurrentLine->len, page14.m_nWrapColumn);
-
-#ifdef USE_REALLOC
-
-    m_pCurrentLine->text  = (char *) realloc (m_pCurrentLine->text, 
-                                              m_pCurrentLine->iMemoryAllocated);  
-
-#else
-    delete [] m_pCurrentLine->text;
-    m_pCurrentLine->text = new char [m_pCurrentLine->iMemoryAllocated];
-#endif
-
-    // check we got it
-    ASSERT (m_pCurrentLine->text);
-
-    // put text back
-    memcpy (m_pCurrentLine->text, (LPCTSTR) strLine, m_pCurrentLine->len);
+      m_pCurrentLine->ResizeText (m_TextArena, 
+                                  MAX ((UINT) m_pCurrentLine->len, page14.m_nWrapColumn));
     }   // end of having a current line
 
   if (m_nWrapColumn != page14.m_nWrapColumn)
@@ -2231,6 +2214,10 @@ Frame.DelayDebugStatus ("World config - loading pages");
   m_bTreeviewTriggers = page8.m_bWantTreeControl;
   m_bTreeviewTimers = page16.m_bWantTreeControl;
 
+  // variables are edited in place (even if cancelled), so triggers which
+  // use them in their match text need to be expanded again
+  NoteAllVariablesChanged ();
+
   if (iResult != IDOK)
     {
     Frame.SetStatusNormal ();
@@ -2427,6 +2414,10 @@ int CMUSHclientDoc::RecompileRegularExpressions ()
     CTrigger * pTrigger;
     GetTriggerMap ().GetNextAssoc (pos, strName, pTrigger);
 
+    // not compiled yet - it will be, with the new setting, when needed
+    if (pTrigger->bCompilePending && pTrigger->regexp == NULL)
+      continue;
+
     if (pTrigger->regexp)
       {
       delete pTrigger->regexp;    // get rid of old one
@@ -2462,6 +2453,10 @@ int CMUSHclientDoc::RecompileRegularExpressions ()
     CAlias * pAlias;
     GetAliasMap ().GetNextAssoc (pos, strName, pAlias);
 
+    // not compiled yet - it will be, with the new setting, when needed
+    if (pAlias->bCompilePending && pAlias->regexp == NULL)
+      continue;
+
     if (pAlias->regexp)
       {
       delete pAlias->regexp;    // get rid of old one
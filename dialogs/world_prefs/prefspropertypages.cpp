@@ -4650,6 +4650,10 @@ ASSERT( trigger->IsKindOf( RUNTIME_CLASS( CTrigger ) ) );
   if (trigger->regexp)
     MakeTableItem   (L, "match_attempts", trigger->regexp->m_iMatchAttempts);
 
+  //  GetTriggerInfo  (39)
+  if (trigger->regexp)
+    MakeTableItem   (L, "backend", CString (trigger->regexp->GetBackendName ()));
+
   }   // end of CPrefsP8::GetFilterInfo
 
 /////////////////////////////////////////////////////////////////////////////
@@ -5804,7 +5808,7 @@ void CPrefsP14::DoDataExchange(CDataExchange* pDX)
 	DDX_Check(pDX, IDC_INDENT_PARAS, m_indent_paras);
 	DDX_Check(pDX, IDC_WRAP_OUTPUT, m_wrap_output);
 	DDX_Text(pDX, IDC_LINES, m_nLines);
-	DDV_MinMaxLong(pDX, m_nLines, 200, 500000);
+	DDV_MinMaxLong(pDX, m_nLines, 200, 1000000);
 	DDX_Text(pDX, IDC_WRAP_COLUMN, m_nWrapColumn);
 	DDV_MinMaxUInt(pDX, m_nWrapColumn, 20, MAX_LINE_WIDTH);
 	DDX_Check(pDX, IDC_LINE_INFORMATION, m_bLineInformation);
@@ -9068,20 +9072,24 @@ void CPrefsP15::CalculateMemoryUsage ()
       }
 
     CLine * pLine = m_doc->m_LineList.GetNext (pos);
-    nMemory += sizeof CLine;          // add the class itself
-    nMemory += pLine->iMemoryAllocated;  // and the text
 
-    // count styles and work out how much memory they take too
+    // count styles and work out how much memory their list items take too
     for (POSITION pos2 = pLine->styleList.GetHeadPosition(); pos2; iStyles++)
       {
       pLine->styleList.GetNext (pos2);
-      nMemory += sizeof CStyle;   // length of style class
-      nMemory += sizeof (void *) * 3;   // and the list item
+      nMemory += sizeof (void *) * 3;   // the list item
       }
 
-    nMemory += sizeof (void *) * 3;   // and the list item
     }
 
+  // the lines, their styles and their text are in the arenas
+  //  (this includes space freed but not yet given back)
+  nMemory += (long) (m_doc->m_LineArena.GetBytesAllocated () + 
+                     m_doc->m_TextArena.GetBytesAllocated ());
+
+  // plus the line list itself
+  nMemory += m_doc->m_LineList.GetMemoryUsed ();
+
   m_strBufferLines += TFormat (" (%i styles)", iStyles);
 	SetDlgItemText(IDC_BUFFER_LINES, m_strBufferLines);
 
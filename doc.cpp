@@ -618,6 +618,8 @@ BEGIN_DISPATCH_MAP(CMUSHclientDoc, CDocument)
 	DISP_PROPERTY_PARAM(CMUSHclientDoc, "BoldColour", GetBoldColour, SetBoldColour, VT_I4, VTS_I2)
 	DISP_PROPERTY_PARAM(CMUSHclientDoc, "CustomColourText", GetCustomColourText, SetCustomColourText, VT_I4, VTS_I2)
 	DISP_PROPERTY_PARAM(CMUSHclientDoc, "CustomColourBackground", GetCustomColourBackground, SetCustomColourBackground, VT_I4, VTS_I2)
+	DISP_FUNCTION(CMUSHclientDoc, "GetLinesMatching", GetLinesMatching, VT_VARIANT, VTS_BSTR VTS_BOOL VTS_BOOL)
+	DISP_FUNCTION(CMUSHclientDoc, "GetMXPMessageCount", GetMXPMessageCount, VT_I4, VTS_I4)
 	//}}AFX_DISPATCH_MAP
 END_DISPATCH_MAP()
 
@@ -743,21 +745,11 @@ void CMUSHclientDoc::SetUpOutputWindow (void)
                   m_input_font_italic);
 
 
-// we defer allocating positions array to now, because m_maxlines is read from the
+// we defer allocating the line list to now, because m_maxlines is read from the
 // document file.
 
-  if (!m_pLinePositions)
-    {
-    m_pLinePositions = new POSITION [(m_maxlines / JUMP_SIZE) + 1];
-
-  // clear all elements
-
-    for (int i = 0; i <= m_maxlines / JUMP_SIZE; i++)
-      m_pLinePositions [i] = NULL;
-
-    m_pLinePositions [0] = m_LineList.GetHeadPosition ();
-
-    }   // end of not having a positions array yet
+  if (m_LineList.GetCapacity () == 0)
+    m_LineList.SetCapacity (m_maxlines);
 
 // we defer allocating the first line to now, because m_nWrapColumn is read from the
 // document file.
@@ -767,7 +759,7 @@ void CMUSHclientDoc::SetUpOutputWindow (void)
   if (!m_pCurrentLine)
     {
     m_total_lines = 0;
-    m_pCurrentLine = new CLine (++m_total_lines, m_nWrapColumn, 0, WHITE, BLACK, m_bUTF_8);
+    m_pCurrentLine = NewLine (++m_total_lines, m_nWrapColumn, 0, WHITE, BLACK, m_bUTF_8, m_LineArena, m_TextArena);
     m_LineList.AddTail (m_pCurrentLine);
     }
 
@@ -1041,6 +1033,7 @@ CString str;
   m_bNoEcho = false;          // no echo suppression yet
   m_iInputPacketCount = 0;
   m_iOutputPacketCount = 0;
+  m_iOutputWriteCount = 0;
   m_iUTF8ErrorCount = 0;
 
   str = TFormat ("Connecting to %s, port %d", 
@@ -1206,6 +1199,9 @@ void CMUSHclientDoc::SendMsg(CString strText,
   if (strList.IsEmpty ())
     strList.AddTail (""); 
 
+  // lines sent straight away go out together
+  CSendBatch batch (this);
+
   for (POSITION pos = strList.GetHeadPosition (); pos; )
     {
     CString strLine = strList.GetNext (pos);
@@ -1352,8 +1348,41 @@ CString str = strText;
 
 void CMUSHclientDoc::ReceiveMsg()
 {
-char buff [1000];   // must be less than COMPRESS_BUFFER_LENGTH or it won't fit
-int count = m_pSocket->Receive (buff, sizeof (buff) - 1);
+// a script (eg. with a message box) can let us be called again while we are
+// still displaying from our buffer - if so, use a separate one for that read
+vector<char> vNestedBuffer;
+char * buff = NULL;
+int iBufferSize;
+CSendBatch batch (this);    // replies from triggers etc. go out together
+
+  if (m_iReceiveNesting == 0)
+    {
+    // adapt the buffer size, now that nothing is using it
+    if (m_pReceiveBuffer && m_iReceiveBufferSize != m_iReceiveBufferWanted)
+      {
+      free (m_pReceiveBuffer);
+      m_pReceiveBuffer = NULL;
+      }
+
+    if (m_pReceiveBuffer == NULL)
+      {
+      m_pReceiveBuffer = (char *) malloc (m_iReceiveBufferWanted);
+      m_iReceiveBufferSize = m_pReceiveBuffer ? m_iReceiveBufferWanted : 0;
+      }
+
+    buff = m_pReceiveBuffer;
+    iBufferSize = m_iReceiveBufferSize;
+    }
+
+  // nested, or out of memory
+  if (buff == NULL)
+    {
+    vNestedBuffer.resize (RECEIVE_BUFFER_MINIMUM);
+    buff = &vNestedBuffer [0];
+    iBufferSize = vNestedBuffer.size ();
+    }
+
+int count = m_pSocket->Receive (buff, iBufferSize - 1);
 
   Frame.CheckTimerFallback ();   // see if time is up for timers to fire
 
@@ -1363,8 +1392,14 @@ int count = m_pSocket->Receive (buff, sizeof (buff) - 1);
     if (m_iConnectPhase == eConnectDisconnecting)
        return;
 
+    int iError = GetLastError ();
+
+    // try to send what triggers have collected before the socket goes
+    if (m_iSendBatchNesting)
+      FlushSendBatch ();
+
     if (m_pSocket)
-      m_pSocket->OnClose (GetLastError ());
+      m_pSocket->OnClose (iError);
 
 		delete m_pSocket;
 		m_pSocket = NULL;
@@ -1424,6 +1459,39 @@ int count = m_pSocket->Receive (buff, sizeof (buff) - 1);
   m_iInputPacketCount++;       // count packets
   m_nBytesIn += count;    // count bytes in
 
+  // count reads per second, for GetInfo
+  DWORD iNow = GetTickCount ();
+  if (iNow - m_iReadsSecondStart >= 1000)
+    {
+    // if a whole second went by with no reads, the last one had none
+    m_iReadsLastSecond = (iNow - m_iReadsSecondStart < 2000) ? m_iReadsThisSecond : 0;
+    m_iReadsThisSecond = 0;
+    m_iReadsSecondStart = iNow;
+    }
+  m_iReadsThisSecond++;
+
+  // filled the buffer? there is probably more to come, so use a larger one next time
+  // getting lots of small reads? go back to a smaller one
+  if (buff == m_pReceiveBuffer)
+    {
+    if (count >= iBufferSize - 1)
+      {
+      if (m_iReceiveBufferWanted < RECEIVE_BUFFER_MAXIMUM)
+        m_iReceiveBufferWanted *= 2;
+      m_iSmallReceiveCount = 0;
+      }
+    else if (count < iBufferSize / 4 && m_iReceiveBufferWanted > RECEIVE_BUFFER_MINIMUM)
+      {
+      if (++m_iSmallReceiveCount >= 100)
+        {
+        m_iReceiveBufferWanted /= 2;
+        m_iSmallReceiveCount = 0;
+        }
+      }
+    else
+      m_iSmallReceiveCount = 0;
+    } // end of using our own buffer
+
   if (m_bCompress)   // if we are compressing, put data into zlib buffer
     {
     if ((COMPRESS_BUFFER_LENGTH - m_zCompress.avail_in) < (uInt) count)
@@ -1454,7 +1522,11 @@ int count = m_pSocket->Receive (buff, sizeof (buff) - 1);
       {
       if (m_logfile && m_bLogRaw)  // raw log if wanted
         WriteToLog (buff, count);  
+      m_iIncomingBatchCount++;
+      m_nIncomingBatchBytes += count;
+      m_iReceiveNesting++;
       DisplayMsg (buff, count, 0);
+      m_iReceiveNesting--;
       }
 
     // if that didn't throw us into compressed, mode, just exit
@@ -1488,9 +1560,11 @@ int count = m_pSocket->Receive (buff, sizeof (buff) - 1);
        // See: http://www.gammon.com.au/forum/?id=11160 
        if (iCompressResult == Z_BUF_ERROR)
          {
-         m_nCompressionOutputBufferSize += COMPRESS_BUFFER_LENGTH;
-         m_zCompress.avail_out += COMPRESS_BUFFER_LENGTH;
+         int iUsed = m_zCompress.next_out - m_CompressOutput;   // realloc may move it
+         m_nCompressionOutputBufferSize += RECEIVE_BUFFER_MINIMUM;
+         m_zCompress.avail_out += RECEIVE_BUFFER_MINIMUM;
          m_CompressOutput = (Bytef *) realloc (m_CompressOutput, m_nCompressionOutputBufferSize);
+         m_zCompress.next_out = m_CompressOutput + iUsed;
 
          if (m_CompressOutput == NULL)
            {
@@ -1539,7 +1613,26 @@ int count = m_pSocket->Receive (buff, sizeof (buff) - 1);
       if (m_logfile && m_bLogRaw)  // raw log if wanted
         WriteToLog ((LPCTSTR) m_CompressOutput, iLength);  
 
+      m_iIncomingBatchCount++;
+      m_nIncomingBatchBytes += iLength;
+      m_iReceiveNesting++;
       DisplayMsg ((LPCTSTR) m_CompressOutput, iLength, 0);    // send uncompressed data to screen
+      m_iReceiveNesting--;
+
+      // filled the output buffer? make it larger, so the next burst is displayed in one go
+      //  (not if nested - the outer call may still be displaying from it)
+      if (iLength >= m_nCompressionOutputBufferSize &&
+          m_nCompressionOutputBufferSize < RECEIVE_BUFFER_MAXIMUM &&
+          m_iReceiveNesting == 0)
+        {
+        Bytef * pNewOutput = (Bytef *) realloc (m_CompressOutput, m_nCompressionOutputBufferSize * 2);
+        if (pNewOutput)
+          {
+          m_CompressOutput = pNewOutput;
+          m_nCompressionOutputBufferSize *= 2;
+          }
+        }
+
       m_zCompress.next_out = m_CompressOutput;      // reset for more output
       m_zCompress.avail_out = m_nCompressionOutputBufferSize;
       }
@@ -1742,6 +1835,124 @@ Unicode range              UTF-8 bytes
   } // end of AddToLine
 
 
+// character classes for TextRunLength
+
+#define TEXT_RUN_ASCII    0x01    // printable, and nothing special to the state machine
+#define TEXT_RUN_SPACE    0x02    // space (special in <p> mode)
+#define TEXT_RUN_HIGH     0x04    // high-order bit set (special if UTF-8), but not IAC
+
+static class CTextRunTable
+  {
+  public:
+
+  unsigned char m_iClass [256];
+
+  CTextRunTable ()
+    {
+    int i;
+
+    ZeroMemory (m_iClass, sizeof m_iClass);
+
+    for (i = '!'; i <= '~'; i++)
+      m_iClass [i] = TEXT_RUN_ASCII;
+    m_iClass ['<'] = 0;   // might start MXP element (or Pueblo)
+    m_iClass ['&'] = 0;   // might start MXP entity
+
+    m_iClass [' '] = TEXT_RUN_SPACE;
+
+    for (i = 0x80; i < IAC; i++)
+      m_iClass [i] = TEXT_RUN_HIGH;
+    }  // end of constructor
+
+  } TextRunTable;
+
+// Returns how many characters at p could go straight into the current line,
+// because DisplayMsg would do nothing more with each of them than AddToLine.
+// Returns 0 if the first one needs to go through the state machine.
+
+int CMUSHclientDoc::TextRunLength (const unsigned char * p, const int size, const int flags)
+  {
+  unsigned char iMask = TEXT_RUN_ASCII;
+  int iRun;
+
+  if (!(flags & NOTE_OR_COMMAND))    // incoming text from the MUD
+    {
+    // part-way through a sequence, or MXP wants to see each character
+    if (m_phase != NONE || 
+        (m_bMXP && (m_bMXP_script || m_iMXP_mode == eMXP_secure_once)))
+      return 0;
+
+    if (!m_bInParagraph)
+      iMask |= TEXT_RUN_SPACE;    // <p> mode squeezes spaces
+    }
+  else
+    iMask |= TEXT_RUN_SPACE;
+
+  // UTF-8 sequences are collected and checked a byte at a time
+  if (!m_bUTF_8)
+    iMask |= TEXT_RUN_HIGH;
+
+  for (iRun = 0; iRun < size; iRun++)
+    if (!(TextRunTable.m_iClass [p [iRun]] & iMask))
+      break;
+
+  return iRun;
+  } // end of CMUSHclientDoc::TextRunLength
+
+// Adds a run of characters (see TextRunLength) to the current line. Whatever fits
+// before the wrap column is copied in one go. AddToLine does the wrapping.
+
+void CMUSHclientDoc::AddRunToLine (const char * p, int iLength, const int flags)
+  {
+  char cOneCharacterLine [2] = {0, 0};
+
+  while (iLength > 0)
+    {
+    int iLineLength = m_pCurrentLine->len;
+
+    // for Unicode the width of the line is characters, not stored bytes
+    //  (the run itself is all single-byte characters)
+    if (m_bUTF_8)
+       iLineLength = MultiByteToWideChar (CP_UTF8, 0, m_pCurrentLine->text, m_pCurrentLine->len, NULL, 0);
+
+    int iRoom = MIN (m_nWrapColumn - iLineLength, 
+                     m_pCurrentLine->iMemoryAllocated - m_pCurrentLine->len);
+
+    // line full - let AddToLine start a new one
+    if (iRoom <= 0)
+      {
+      cOneCharacterLine [0] = *p++;
+      iLength--;
+      AddToLine (cOneCharacterLine, flags);
+      continue;
+      }
+
+    int iCount = MIN (iRoom, iLength);
+
+    ASSERT (m_pCurrentLine->text);
+
+    memcpy (&m_pCurrentLine->text [m_pCurrentLine->len], p, iCount);
+
+    // remember the last space, for wrapping
+    for (int i = iCount - 1; i >= 0; i--)
+      if (p [i] == ' ')
+        {
+        m_pCurrentLine->last_space = m_pCurrentLine->len + i;
+        break;
+        }
+
+    m_pCurrentLine->len += iCount;    // line has that many more characters
+
+    // style spans them too
+    m_pCurrentLine->styleList.GetTail ()->iLength += iCount; 
+
+    p += iCount;
+    iLength -= iCount;
+    } // end of while more to add
+
+  } // end of CMUSHclientDoc::AddRunToLine
+
+
 // called when starting a new line to get colours right
 
 void CMUSHclientDoc::SetNewLineColour (const int flags)
@@ -1832,7 +2043,7 @@ CString strOriginalText;
 CString strLine (lpszText, size);
 
   // cannot go very far without this - must be called at world loadup from a plugin OnPluginInstall
-  if (m_pLinePositions == NULL)
+  if (m_LineList.GetCapacity () == 0)
     return;
 
   // decompressed data has a size, not a null terminator.
@@ -1914,6 +2125,27 @@ CString strLine (lpszText, size);
 
     c = *p;
 
+    // ordinary text (the usual case) goes straight into the line, a run at a time
+    int iTextRun = TextRunLength ((const unsigned char *) p, size, flags);
+    if (iTextRun > 0)
+      {
+      AddRunToLine (p, iTextRun, flags);
+
+      // remember the last character, as for each one below
+      //  (a newline followed by only spaces still counts as a newline)
+      if (!(flags & NOTE_OR_COMMAND))
+        {
+        for (i = iTextRun - 1; i >= 0 && p [i] == ' '; i--)
+          ;   // find last non-space
+        if (i >= 0 || m_cLastChar != '\n')
+          m_cLastChar = p [iTextRun - 1];
+        }
+
+      p += iTextRun - 1;      // the loop does the last one
+      size -= iTextRun - 1;
+      continue;
+      }
+
     // bail out of UTF-8 collection if a non-high order bit is found in the incoming stream
     if (!(flags & NOTE_OR_COMMAND) && 
         m_phase == HAVE_UTF8_CHARACTER && 
@@ -2044,10 +2276,29 @@ CString strLine (lpszText, size);
           }   // end of HAVE_SUBNEGOTIATION_IAC
 
         // MXP phases             
-        case HAVE_MXP_ELEMENT:     Phase_MXP_ELEMENT (c); continue;
-        case HAVE_MXP_COMMENT:     Phase_MXP_COMMENT (c); continue;
-        case HAVE_MXP_QUOTE:       Phase_MXP_QUOTE (c); continue;
-        case HAVE_MXP_ENTITY:      Phase_MXP_ENTITY (c); continue;
+        case HAVE_MXP_ELEMENT:     
+        case HAVE_MXP_COMMENT:     
+        case HAVE_MXP_QUOTE:       
+        case HAVE_MXP_ENTITY:      
+            {
+            // collect ordinary characters in one go
+            int iRun = Phase_MXP_RUN (p, size);
+            if (iRun > 0)
+              {
+              p += iRun - 1;      // the loop does the last one
+              size -= iRun - 1;
+              continue;
+              }
+            }
+
+            switch (m_phase)
+              {
+              case HAVE_MXP_ELEMENT:     Phase_MXP_ELEMENT (c); break;
+              case HAVE_MXP_COMMENT:     Phase_MXP_COMMENT (c); break;
+              case HAVE_MXP_QUOTE:       Phase_MXP_QUOTE (c); break;
+              case HAVE_MXP_ENTITY:      Phase_MXP_ENTITY (c); break;
+              } // end of switch
+            continue;
 
         case HAVE_MXP_ROOM_NAME:
         case HAVE_MXP_ROOM_DESCRIPTION:
@@ -2433,31 +2684,23 @@ POSITION pos;
     if (m_pCurrentLine)
       {
 
-  // We are about to move onto a new line. For space reasons, reallocate them
-  // memory used by the pointers. However to keep from getting a null pointer,
-  // keep at least a single character
-
-    // save current line text
-     CString strLine = CString (m_pCurrentLine->text, m_pCurrentLine->len);
+  // We are about to move onto a new line. For space reasons, give back the
+  // unused end of the text buffer. It is the most recent thing in the text
+  // arena, so this is done in place, without copying the text.
+  // However to keep from getting a null pointer, keep at least a single character
 
-     m_pCurrentLine->iMemoryAllocated = MAX (m_pCurrentLine->len, 1);
+    if (m_TextArena.Shrink (m_pCurrentLine->text, 
+                            m_pCurrentLine->iMemoryAllocated, 
+                            MAX (m_pCurrentLine->len, 1)))
+      m_pCurrentLine->iMemoryAllocated = MAX (m_pCurrentLine->len, 1);
 
-#ifdef USE_REALLOC
-      m_pCurrentLine->text  = (char *) realloc (m_pCurrentLine->text, 
-                                               m_pCurrentLine->iMemoryAllocated);
+  // The line is finished, so note what is in it, to speed up finding.
+  // If it isn't at the end of the buffer (can that happen?) leave it as
+  // "might contain anything".
 
-#else
-
-    delete [] m_pCurrentLine->text;
-    m_pCurrentLine->text = new char [m_pCurrentLine->iMemoryAllocated];
-
-
-#endif
-      
-    ASSERT (m_pCurrentLine->text);
-
-    // put text back
-    memcpy (m_pCurrentLine->text, (LPCTSTR) strLine, m_pCurrentLine->len);
+    long nCount = m_LineList.GetCount ();
+    if (nCount > 0 && m_LineList.GetTail () == m_pCurrentLine)
+      m_pCurrentLine->Sign (nCount > 1 ? m_LineList.GetLine (nCount - 2) : NULL);
 
       // if we have more than one style, and the last one is empty, get rid of it
       // unless it is a start tag marker
@@ -2519,24 +2762,17 @@ POSITION pos;
           }
         } // end of note 
 
-    m_pCurrentLine = new CLine (++m_total_lines, 
-                                m_nWrapColumn,
-                                iFlags,       // style flags
-                                iForeColour,  
-                                iBackColour,
-                                m_bUTF_8);
+    m_pCurrentLine = NewLine (++m_total_lines, 
+                              m_nWrapColumn,
+                              iFlags,       // style flags
+                              iForeColour,  
+                              iBackColour,
+                              m_bUTF_8,
+                              m_LineArena,
+                              m_TextArena);
 
     m_pCurrentLine->flags = flags;
-    pos = m_LineList.AddTail (m_pCurrentLine);
-
-// add every "JUMP_SIZE" line positions to the positions array
-
-// we match the modulus on 1, not zero, because by this time the line has already been
-// added to the line count, so the line count is 1-relative, not 0-relative, however
-// we want to place the line in the line positions array zero relative.
-
-    if (m_LineList.GetCount () % JUMP_SIZE == 1)
-      m_pLinePositions [m_LineList.GetCount () / JUMP_SIZE] = pos;
+    m_LineList.AddTail (m_pCurrentLine);
 
     }   // end of try block
 
@@ -3538,6 +3774,9 @@ DWORD nLines = 0,
   ProgressDlg.SetRange (0, nLines);
   ProgressDlg.SetWindowText (Translate ("Sending..."));                              
 
+  // lines go out together, except where a delay between lines is wanted
+  CSendBatch batch (this);
+
   try
     {
 
@@ -3587,6 +3826,7 @@ DWORD nLines = 0,
             {
             if (++iLineCount >= dlg.m_nLineDelayPerLines)
               {
+              FlushSendBatch ();   // send what we have before pausing
               Sleep (dlg.m_iLineDelay);
               iLineCount = 0;
               }
@@ -3627,6 +3867,7 @@ DWORD nLines = 0,
         {
         if (++iLineCount >= dlg.m_nLineDelayPerLines)
           {
+          FlushSendBatch ();   // send what we have before pausing
           Sleep (dlg.m_iLineDelay);
           iLineCount = 0;
           }
@@ -3643,6 +3884,7 @@ DWORD nLines = 0,
         {
         if (++iLineCount >= dlg.m_nLineDelayPerLines)
           {
+          FlushSendBatch ();   // send what we have before pausing
           Sleep (dlg.m_iLineDelay);
           iLineCount = 0;
           }
@@ -4257,6 +4499,10 @@ void CMUSHclientDoc::OnConnectionDisconnect()
 	if (m_pSocket)
 	{
 
+    // send anything collected so far (eg. an alias which sends "quit" then disconnects)
+    if (m_iSendBatchNesting)
+      FlushSendBatch ();
+
     ShutDownSocket (*m_pSocket);
 
     m_pSocket->OnClose (0);
@@ -4282,7 +4528,6 @@ BOOL CMUSHclientDoc::FixUpOutputBuffer (int nNewBufferSize)
   {
 
 POSITION pos;
-long i;
 
   if (!m_pCurrentLine)
     return FALSE;             // too early for this crap
@@ -4294,26 +4539,9 @@ long i;
   while (m_LineList.GetCount () > nNewBufferSize)
     RemoveChunk ();
 
-// do a new line positions array
-
-  delete [] m_pLinePositions;
-  m_pLinePositions = new POSITION [(nNewBufferSize / JUMP_SIZE) + 1];
-
-// clear all elements
+// resize the line list to suit
 
-  for (i = 0; i <= nNewBufferSize / JUMP_SIZE; i++)
-    m_pLinePositions [i] = NULL;
-
-// re-seed positions array
-
-  for(i = 0, pos=m_LineList.GetHeadPosition();
-      pos;
-      i++)
-        {
-        if (i % JUMP_SIZE == 0)
-          m_pLinePositions [i / JUMP_SIZE] = pos;
-        m_LineList.GetNext (pos);
-        } // end of for loop
+  m_LineList.SetCapacity (nNewBufferSize);
 
 // refresh view to show different scroll bars
 
@@ -4356,56 +4584,18 @@ void CMUSHclientDoc::OnUpdateGamePreferences(CCmdUI* pCmdUI)
 
 POSITION CMUSHclientDoc::GetLinePosition (long nLine)
   {
-POSITION pos = NULL;
 
   // sanity check  (Santa Claus)
-  if (nLine > m_LineList.GetCount ())
-    nLine = m_LineList.GetCount ();
+  //  - past the end, assume last one in the list
+  if (nLine >= m_LineList.GetCount ())
+    nLine = m_LineList.GetCount () - 1;
 
   if (nLine < 0)
     nLine = 0;
 
-static long iCount = 0;
-int nIndex = nLine / JUMP_SIZE,
-    nItem = nIndex * JUMP_SIZE;
-
-  if (m_pLinePositions)
-    {
-    pos = m_pLinePositions [nIndex];
-
-  // not there, try previous item
-
-    if (!pos && nIndex > 0)
-      {
-      pos = m_pLinePositions [nIndex - 1];
-      nItem -= JUMP_SIZE;
-      }
-    }   // end of having a positions array
-
-// as a last resort, use the start of the list
-
-  if (!pos)
-    {
-    pos = m_LineList.GetHeadPosition ();
-    nItem = 0;
-    }
-
-// now count forwards until we hit the actual one we want
-
-  for (long i = nItem; i < nLine && pos; i++)
-    {
-    iCount++;
-    m_LineList.GetNext (pos);
-    }
-
-// not there? assume last one in the list
-
-  if (!pos)
-    pos = m_LineList.GetTailPosition ();
-
 // return the desired position
 
-  return pos;
+  return m_LineList.GetPosition (nLine);
 
   } // end of CMUSHclientDoc::GetLinePosition
 
@@ -4436,13 +4626,6 @@ long CMUSHclientDoc::GetLastLine (void)
     m_LineList.RemoveHead ();
     }
 
-// shuffle positions backwards
-
-  for (i = 0; i < (m_maxlines / JUMP_SIZE); i++)
-    m_pLinePositions [i] = m_pLinePositions [i + 1];
-
-  m_pLinePositions [i] = NULL;    // last one is now empty
-
 // our "last found" line needs adjusting
 
   m_DisplayFindInfo.m_nCurrentLine -= JUMP_SIZE;
@@ -4706,6 +4889,16 @@ void CMUSHclientDoc::SetUpVariantString (VARIANT & tVariant, const CString & str
   {
   VariantClear (&tVariant);
   tVariant.vt = VT_BSTR;
+
+  // a Lua binding is waiting for this - hand over the string as it is
+  if (m_pLuaStringResult)
+    {
+    *m_pLuaStringResult = strContents;
+    m_pLuaStringResult = NULL;    // only the first one
+    tVariant.bstrVal = NULL;      // see CLuaStringResult::Push
+    return;
+    }
+
   tVariant.bstrVal = strContents.AllocSysString (); 
   }   // end of CMUSHclientDoc::SetUpVariantString
 
@@ -4812,7 +5005,7 @@ BOOL bEnable = TRUE;
 void CMUSHclientDoc::ClearOutput (void)
   {
 
-  if (m_pLinePositions == NULL)
+  if (m_LineList.GetCapacity () == 0)
     return;
 
 POSITION pos;
@@ -4824,21 +5017,16 @@ POSITION pos;
 // put one line in line list
 
   m_total_lines = 0;
-  m_pCurrentLine = new CLine (++m_total_lines, 
-                              m_nWrapColumn,
-                              0, WHITE, BLACK,
-                              m_bUTF_8);
+  m_pCurrentLine = NewLine (++m_total_lines, 
+                            m_nWrapColumn,
+                            0, WHITE, BLACK,
+                            m_bUTF_8,
+                            m_LineArena,
+                            m_TextArena);
 
   m_LineList.AddTail (m_pCurrentLine);
 //  m_strCurrentLine.Empty ();
 
-  // clear all elements in our positions array
-
-  for (int i = 0; i <= m_maxlines / JUMP_SIZE; i++)
-    m_pLinePositions [i] = NULL;
-
-  m_pLinePositions [0] = m_LineList.GetHeadPosition ();
-
   // previous find won't work now
 
   m_DisplayFindInfo.m_nCurrentLine = 0;
@@ -4900,7 +5088,8 @@ int iCurrentLine;
 
   // compile regular expression if needed
   if (bRegexp)
-    regexp = regcomp (strSearchString, (bMatchCase ? 0 : PCRE_CASELESS) | (m_bUTF_8 ? PCRE_UTF8 : 0));
+    regexp = regcomp (strSearchString, (bMatchCase ? 0 : PCRE_CASELESS) | (m_bUTF_8 ? PCRE_UTF8 : 0), 
+                      true);    // we only want to know if it matches
 
 CString strFindString = strSearchString;
 CString strStatus = TFormat ("Recalling: %s", (LPCTSTR) strSearchString);
@@ -5747,7 +5936,9 @@ void  CMUSHclientDoc::SendPacket (const char * lpBuf, const int nBufLen)
 
   m_pSocket->m_outstanding_data += CString (lpBuf, nBufLen);
 
-  m_pSocket->OnSend (0);   // in case FD_WRITE message got lost, try to send again
+  // if collecting output, it is sent when the batch ends (see EndSendBatch)
+  if (m_iSendBatchNesting == 0)
+    m_pSocket->OnSend (0);   // in case FD_WRITE message got lost, try to send again
   
   m_nBytesOut += nBufLen; 
 
@@ -5758,6 +5949,33 @@ void  CMUSHclientDoc::SendPacket (const unsigned char * lpBuf, const int nBufLen
   SendPacket ((const char *) lpBuf, nBufLen);
   } // end of CMUSHclientDoc::SendPacket 
 
+void CMUSHclientDoc::EndSendBatch (void)
+  {
+
+  if (m_iSendBatchNesting <= 0)
+    {
+    m_iSendBatchNesting = 0;    // unbalanced - never go negative
+    return;
+    }
+
+  if (--m_iSendBatchNesting > 0)
+    return;   // still inside an outer batch
+
+  FlushSendBatch ();    // send everything collected in one go
+
+  } // end of CMUSHclientDoc::EndSendBatch 
+
+// send whatever has been collected so far, without ending the batch
+
+void CMUSHclientDoc::FlushSendBatch (void)
+  {
+  // the socket may have gone while we were collecting (eg. the connection dropped)
+  if (m_pSocket == NULL || m_pSocket->m_outstanding_data.IsEmpty ())
+    return;
+
+  m_pSocket->OnSend (0);
+  } // end of CMUSHclientDoc::FlushSendBatch 
+
 void CMUSHclientDoc::OnEditFliptonotepad() 
 {
 CTextDocument * pTextDoc = NULL;
@@ -6122,6 +6340,8 @@ POSITION pos;
      GetTriggerRevMap () [pTrigger] = strTriggerName;
     }
 
+  // automaton must be rebuilt for the new order
+  GetTriggerPrefilter ().Invalidate ();
 
   // sort the array
   qsort (GetTriggerArray ().GetData (), 
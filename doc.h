@@ -13,9 +13,12 @@
 #include "xml\xmlparse.h"
 #include "paneline.h"
 #include "miniwindow.h"
+#include "TriggerPrefilter.h"
 #include "plugins.h"
 
-#define COMPRESS_BUFFER_LENGTH 1024   // size of decompression buffer
+#define RECEIVE_BUFFER_MINIMUM (16 * 1024)    // smallest socket receive buffer
+#define RECEIVE_BUFFER_MAXIMUM (256 * 1024)   // largest socket receive buffer
+#define COMPRESS_BUFFER_LENGTH RECEIVE_BUFFER_MAXIMUM   // size of decompression input buffer (holds a whole read)
 
 // ============================================================================
 
@@ -684,9 +687,11 @@ public:
   CAliasRevMap m_AliasRevMap;     // for getting name back from pointer
   CTriggerMap m_TriggerMap;       
   CTriggerArray m_TriggerArray;   // array of triggers for sequencing
+  CTriggerPrefilter m_TriggerPrefilter; // literal text prefilter for m_TriggerArray
   CTriggerRevMap m_TriggerRevMap; // for getting name back from pointer
   CTimerMap m_TimerMap;
   CTimerRevMap m_TimerRevMap;     // for getting name back from pointer
+  CTimerQueue m_TimerQueue;       // which timers are due next
 
 
 // new in version 7
@@ -727,6 +732,7 @@ public:
   unsigned short m_bKeepCommandsOnSameLine; // commands stay on same line as prompt from MUD
 
   CVariableMap m_VariableMap;        // program variables (map)
+  CVariableDependencyMap m_VariableDependencies;  // which triggers use which variables
 
   CString         m_strAutoSayString;
   unsigned short  m_bEnableAutoSay;
@@ -996,7 +1002,21 @@ public:
   bool m_bDebugIncomingPackets;   // set if we want to display all incoming text
 
   __int64 m_iInputPacketCount;          // count of packets received
+
+  // socket receive buffer - grows when reads fill it, shrinks when they stay small
+  char * m_pReceiveBuffer;              // incoming data is read into here
+  int m_iReceiveBufferSize;             // size allocated
+  int m_iReceiveBufferWanted;           // size we will use for the next read
+  int m_iSmallReceiveCount;             // consecutive reads using under a quarter of it
+  int m_iReceiveNesting;                // > 0 while incoming data is being displayed
+  __int64 m_iIncomingBatchCount;        // times DisplayMsg was given incoming data
+  __int64 m_nIncomingBatchBytes;        // total bytes it was given
+  DWORD m_iReadsSecondStart;            // GetTickCount when current second of reads started
+  long m_iReadsThisSecond;              // reads in current second
+  long m_iReadsLastSecond;              // reads in previous second
   __int64 m_iOutputPacketCount;         // count of packets sent
+  __int64 m_iOutputWriteCount;          // count of socket writes (packets may be batched)
+  int m_iSendBatchNesting;              // > 0 while collecting output (see CSendBatch)
   long m_iUTF8ErrorCount;               // count of lines with bad UTF8
   long m_iOutputWindowRedrawCount;      // count of times output window redrawn
 
@@ -1004,10 +1024,12 @@ public:
   int  m_iUTF8BytesLeft;                // how many UTF8 bytes to go
 
   long m_iTriggersEvaluatedCount;    // how many triggers we evaluated
+  long m_iTriggersPrefilteredCount;  // how many triggers the prefilter let us skip
   long m_iTriggersMatchedCount;      // how many triggers matched
   long m_iAliasesEvaluatedCount;     // how many aliases we evaluated 
   long m_iAliasesMatchedCount;       // how many aliases matched      
   long m_iTimersFiredCount;          // how many timers fired
+  long m_iRegexpsPending;            // triggers/aliases loaded but not compiled yet (approx.)
 
   long m_iTriggersMatchedThisSessionCount;      // how many triggers matched this connection
   long m_iAliasesMatchedThisSessionCount;       // how many aliases matched this connection      
@@ -1025,6 +1047,11 @@ public:
   CSendView * m_pActiveCommandView;
   CMUSHView * m_pActiveOutputView;
 
+// where output buffer lines, their styles and their text live (see LineArena.h)
+
+  CLineArena m_LineArena;     // CLine and CStyle objects
+  CLineArena m_TextArena;     // line text
+
 // list of output buffer lines
 
   CLineList m_LineList;
@@ -1036,10 +1063,7 @@ public:
 // list of actions for style runs
 
   CActionList m_ActionList;
-
-// we will record the position of each JUMP_SIZE lines, to speed up lookups
-
-  POSITION * m_pLinePositions;  // array of line positions
+  CActionHashMap m_ActionHashMap;   // m_ActionList by hash, for GetAction
 
   long m_total_lines;
   long m_new_lines;   // lines they haven't read yet (if not active view)
@@ -1123,6 +1147,7 @@ public:
   // These two are defined with !ELEMENT and !ENTITY
   CElementMap         m_CustomElementMap;   // Custom MXP elements 
   CMapStringToString  m_CustomEntityMap;    // Custom MXP entities
+  CEntityTable        m_CustomEntityTable;  // the same, for fast lookup
 
   CActiveTagList  m_ActiveTagList;  // MXP elements currently active (eg. <bold> )
 
@@ -1139,6 +1164,9 @@ public:
   __int64 m_iMXPerrors;
   __int64 m_iMXPtags;
   __int64 m_iMXPentities;
+  __int64 m_iMXPmessagesSuppressed;   // messages nobody would have seen
+
+  map<long, long> m_MXPmessageCounts;   // times each message number was raised
 
   // end MXP stuff
 
@@ -1306,6 +1334,9 @@ public:
 
   CPluginList m_PluginList;     // plugins
   CPlugin *   m_CurrentPlugin;  // plugin currently active, NULL if none
+  CPluginSubscribersMap m_PluginSubscribers;  // which plugins have which callbacks
+  bool        m_bPluginSubscribersValid;      // false if m_PluginSubscribers must be rebuilt
+  long        m_iPluginSubscribersGeneration; // incremented when the plugin list changes
   bool        m_bPluginProcessingCommand; // plugin is doing ON_PLUGIN_COMMAND
   bool        m_bPluginProcessingSend; // plugin is doing ON_PLUGIN_SEND
   bool        m_bPluginProcessingSent; // plugin is doing ON_PLUGIN_SENT
@@ -1417,6 +1448,8 @@ public:
 	void ReceiveMsg();
 	void DisplayMsg(LPCTSTR lpszText, int size, const int flags);
   void AddToLine (LPCTSTR lpszText, const int flags);
+  void AddRunToLine (const char * p, int iLength, const int flags);
+  int  TextRunLength (const unsigned char * p, const int size, const int flags);
   void StartNewLine_KeepPreviousStyle (const int flags);
   void Phase_ESC (const unsigned char c);  
   void Phase_UTF8 (const unsigned char c);  
@@ -1452,6 +1485,7 @@ public:
   void Phase_MXP_QUOTE (const unsigned char c);           
   void Phase_MXP_ENTITY (const unsigned char c);            
   void Phase_MXP_COLLECT_SPECIAL (const unsigned char c);           
+  int  Phase_MXP_RUN (const unsigned char * p, const int size);
 
   // other MXP processing
 
@@ -1460,6 +1494,7 @@ public:
   void MXP_collected_element (void);
   void MXP_collected_entity (void);
   void MXP_error (const int iLevel, const long iMessageNumber, CString strMessage);
+  bool MXP_SuppressMessage (const int iLevel, const long iMessageNumber);
   void MXP_Definition (CString strTag);
   void MXP_Element (CString strName, CString strTag);
   void MXP_Entity  (CString strName, CString strTag);
@@ -1483,6 +1518,11 @@ public:
                            const POSITION firstlinepos,
                            const POSITION firststylepos);
   CString MXP_GetEntity (CString & strName);
+  const char * MXP_FindEntity (const char * sName, const int iLength, 
+                               CString & strContents,
+                               char * sCharacter, int & iResultLength);
+  void MXP_SetCustomEntity (const CString & strName, const CString & strValue);
+  void MXP_RemoveCustomEntity (const CString & strName);
   bool BuildArgumentList (CArgumentList & ArgumentList, 
                           CString strTag);
 
@@ -1520,6 +1560,8 @@ public:
   void Debug_Packets (LPCTSTR sCaption, LPCTSTR lpszText, int size, const __int64 iNumber);
   void SendPacket (const char * lpBuf, const int nBufLen);   // low-level send
   void SendPacket (const unsigned char * lpBuf, const int nBufLen);   // low-level send
+  void EndSendBatch (void);   // see CSendBatch
+  void FlushSendBatch (void);
 
   // finds an action, adding it if necessary
   CAction * GetAction (const CString & strAction,
@@ -1803,7 +1845,8 @@ public:
                               CString & output, 
                               int & iItem,
                               int & iStartCol,
-                              int & iEndCol);
+                              int & iEndCol,
+                              const unsigned long iPrefilterScan);
 
   CString FixSendText (const CString strSource, 
                             const int iSendTo,
@@ -1816,6 +1859,25 @@ public:
                             const bool bIsRegexp,   // true = regexp trigger
                             const bool bThrowExceptions,   // throw exception on error
                             const char * sName);           // the name of the trigger/timer/alias (for %N)
+  CString ExpandSendText (const CSendTemplate & SendTemplate,
+                            const int iSendTo,
+                            const t_regexp * regexp,    // regular expression (for triggers, aliases)
+                            const char * sLanguage, // language for send-to-script
+                            const bool bMakeWildcardsLower,
+                            const bool bFixRegexps, // convert \ to \\ for instance
+                            const bool bIsRegexp,   // true = regexp trigger
+                            const bool bThrowExceptions,   // throw exception on error
+                            const char * sName);           // the name of the trigger/timer/alias (for %N)
+
+  // for regular expressions whose compilation was deferred when loaded
+  void CompileTriggerRegexp (CTrigger * trigger_item);
+  void CompileAliasRegexp (CAlias * alias_item);
+  void CompilePendingRegexps (const int iMaximum);
+
+  // for triggers which expand variables in their match text
+  void NoteTriggerVariables (CTrigger * trigger_item);
+  void NoteVariableChanged (const CString & strVariableName);
+  void NoteAllVariablesChanged (void);
 
 #ifdef PANE
 
@@ -1868,7 +1930,7 @@ public:
   void Interpret256ANSIcode (const int iCode);
   void ResetOneTimer (CTimer * timer_item);
   void ResetAllTimers (CTimerMap & TimerMap);
-  void CheckTimerList (CTimerMap & TimerMap);
+  void CheckTimerList (CTimerMap & TimerMap, CTimerQueue & TimerQueue);
   void CheckTimers (void);
   void CheckTickTimers (void);
 
@@ -1921,6 +1983,7 @@ public:
   void FindGlobalEntryPoints (CString & strErrorMessage);
 
   void SetUpVariantString (VARIANT & tVariant, const CString & strContents);
+  CString * m_pLuaStringResult;   // Lua binding wants the string itself (see CLuaStringResult)
   void SetUpVariantShort  (VARIANT & tVariant, const short iContents);
   void SetUpVariantBool   (VARIANT & tVariant, const BOOL iContents);
   void SetUpVariantLong   (VARIANT & tVariant, const long iContents);
@@ -1966,6 +2029,13 @@ public:
   CPlugin * GetPlugin (LPCTSTR PluginID);
   CMUSHView * GetFirstOutputWindow ();
 
+  // the enabled plugins which have callback sName, in plugin order
+  const CPluginVector & GetPluginSubscribers (const string & sName);
+  // call when plugins are added, removed, enabled or disabled
+  void PluginSubscribersChanged (void);
+  // false if pPlugin has been removed or disabled since iGeneration
+  bool IsPluginStillSubscribed (CPlugin * pPlugin, const long iGeneration);
+
   // calls sName in all plugins
   void SendToAllPluginCallbacks (const string & sName);   // no arguments
 
@@ -2172,6 +2242,14 @@ public:
       return m_TriggerArray;
     };
 
+  CTriggerPrefilter & GetTriggerPrefilter (void)
+    {
+    if (m_CurrentPlugin)
+      return m_CurrentPlugin->m_TriggerPrefilter;
+    else
+      return m_TriggerPrefilter;
+    };
+
   CTriggerRevMap & GetTriggerRevMap (void)
     {
     if (m_CurrentPlugin)
@@ -2220,6 +2298,14 @@ public:
       return m_TimerRevMap;
     };
 
+  CTimerQueue & GetTimerQueue (void)
+    {
+    if (m_CurrentPlugin)
+      return m_CurrentPlugin->m_TimerQueue;
+    else
+      return m_TimerQueue;
+    };
+
   CVariableMap & GetVariableMap (void)
     {
     if (m_CurrentPlugin)
@@ -2228,6 +2314,14 @@ public:
       return m_VariableMap;
     };
 
+  CVariableDependencyMap & GetVariableDependencies (void)
+    {
+    if (m_CurrentPlugin)
+      return m_CurrentPlugin->m_VariableDependencies;
+    else
+      return m_VariableDependencies;
+    };
+
   CScriptEngine * GetScriptEngine (void)
     {
     if (m_CurrentPlugin)
@@ -2835,12 +2929,30 @@ public:
 	afx_msg void SetCustomColourText(short WhichColour, long nNewValue);
 	afx_msg long GetCustomColourBackground(short WhichColour);
 	afx_msg void SetCustomColourBackground(short WhichColour, long nNewValue);
+	afx_msg VARIANT GetLinesMatching(LPCTSTR Text, BOOL MatchCase, BOOL Regexp);
+	afx_msg long GetMXPMessageCount(long MessageNumber);
 	//}}AFX_DISPATCH
 	DECLARE_DISPATCH_MAP()
 	DECLARE_INTERFACE_MAP()
 
 };
 
+// While one of these exists, packets for the MUD are collected rather than
+// written to the socket one by one - they are written together when the
+// outermost one goes (so an alias sending 50 lines makes one write, not 50).
+
+class CSendBatch
+  {
+  CMUSHclientDoc * m_pDoc;
+
+  public:
+
+  CSendBatch (CMUSHclientDoc * pDoc) : m_pDoc (pDoc) 
+    { m_pDoc->m_iSendBatchNesting++; };
+  ~CSendBatch () 
+    { m_pDoc->EndSendBatch (); };
+  };    // end of class CSendBatch
+
 /////////////////////////////////////////////////////////////////////////////
 
 
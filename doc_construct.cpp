@@ -16,7 +16,10 @@ extern int gdoccount;
 // CMUSHclientDoc construction/destruction
 
 CMUSHclientDoc::CMUSHclientDoc()
-  :	m_eventScriptFileChanged(FALSE, TRUE)
+  :	m_LineArena (8),    // objects need aligning
+    m_TextArena (1),    // text doesn't
+    m_CustomEntityTable (true),   // MXP entity names are case-insensitive
+    m_eventScriptFileChanged(FALSE, TRUE)
 
 {    // constructor
 
@@ -24,6 +27,7 @@ int i;
 
   // each document will have a unique number
   m_iUniqueDocumentNumber = App.GetUniqueNumber ();
+  App.m_WorldDocuments [m_iUniqueDocumentNumber] = this;
 
   m_whenWorldStarted = CTime::GetCurrentTime();
   QueryPerformanceCounter (&m_whenWorldStartedHighPrecision);
@@ -65,10 +69,12 @@ int i;
   m_bTabCompleteFunctions = true;
 
   m_iTriggersEvaluatedCount = 0; 
+  m_iTriggersPrefilteredCount = 0;
   m_iTriggersMatchedCount = 0;   
   m_iAliasesEvaluatedCount = 0;  
   m_iAliasesMatchedCount = 0;    
   m_iTimersFiredCount = 0;       
+  m_iRegexpsPending = 0;
   m_iTriggersMatchedThisSessionCount = 0;   
   m_iAliasesMatchedThisSessionCount = 0;    
   m_iTimersFiredThisSessionCount = 0;       
@@ -101,6 +107,8 @@ int i;
   m_bDebugIncomingPackets = false;
   m_iInputPacketCount = 0;
   m_iOutputPacketCount = 0;
+  m_iOutputWriteCount = 0;
+  m_iSendBatchNesting = 0;
   m_iUTF8ErrorCount = 0;
   m_lastGoTo = 1;
   m_bNAWS_wanted = false;
@@ -227,7 +235,18 @@ int i;
   m_nTotalUncompressed = 0;
   m_nTotalCompressed = 0;
   m_iCompressionTimeTaken = 0;
-  m_nCompressionOutputBufferSize = COMPRESS_BUFFER_LENGTH;  // initial value
+  m_nCompressionOutputBufferSize = RECEIVE_BUFFER_MINIMUM;  // initial value - grows with the bursts
+
+  m_pReceiveBuffer = NULL;    // allocated on first read
+  m_iReceiveBufferSize = 0;
+  m_iReceiveBufferWanted = RECEIVE_BUFFER_MINIMUM;
+  m_iSmallReceiveCount = 0;
+  m_iReceiveNesting = 0;
+  m_iIncomingBatchCount = 0;
+  m_nIncomingBatchBytes = 0;
+  m_iReadsSecondStart = 0;
+  m_iReadsThisSecond = 0;
+  m_iReadsLastSecond = 0;
 
   // we will defer initialising zlib until we really have to
 
@@ -342,7 +361,6 @@ int i;
   ZeroMemory (&m_ProxyAddr, sizeof m_ProxyAddr);
   m_hNameLookup = NULL;
   m_pGetHostStruct = NULL;
-  m_pLinePositions = NULL;
 
   m_pCurrentLine = NULL;
   m_total_lines = 0;
@@ -373,6 +391,9 @@ int i;
   m_iMXPerrors = 0;     
   m_iMXPtags = 0;       
   m_iMXPentities = 0;   
+  m_iMXPmessagesSuppressed = 0;
+
+  m_pLuaStringResult = NULL;
 
   // scripting support
 
@@ -409,6 +430,9 @@ int i;
   m_bPluginProcessesSetEntity = false;
   m_bPluginProcessesError = false;      
 
+  m_bPluginSubscribersValid = false;
+  m_iPluginSubscribersGeneration = 0;
+
   ZeroMemory (&m_bClient_sent_IAC_DO,   sizeof m_bClient_sent_IAC_DO);
   ZeroMemory (&m_bClient_sent_IAC_DONT, sizeof m_bClient_sent_IAC_DONT);
   ZeroMemory (&m_bClient_sent_IAC_WILL, sizeof m_bClient_sent_IAC_WILL);
@@ -474,6 +498,9 @@ CMUSHclientDoc::~CMUSHclientDoc()
 {
 int i;
 
+  // scripts holding on to this world must no longer find it
+  App.m_WorldDocuments.erase (m_iUniqueDocumentNumber);
+
   // stop sounds playing, release sound buffers
   for (i = 0; i < MAX_SOUND_BUFFERS; i++)
     if (m_pDirectSoundSecondaryBuffer [i])
@@ -507,6 +534,9 @@ int i;
 	if (m_pSocket)
 	{
 
+    if (m_iSendBatchNesting)
+      FlushSendBatch ();    // don't lose output collected for the MUD
+
     ShutDownSocket (*m_pSocket);
 
     delete m_pSocket;
@@ -578,11 +608,11 @@ int i;
 // delete actions list
 
   DELETE_LIST (m_ActionList);
+  m_ActionHashMap.clear ();
 
 
 // get rid of our positions array
 
-  delete [] m_pLinePositions;
 
 // one less document
 
@@ -606,6 +636,9 @@ int i;
   if (m_CompressInput)
     free (m_CompressInput);
 
+  if (m_pReceiveBuffer)
+    free (m_pReceiveBuffer);
+
   // don't wrap up if not initialised
   if (m_bCompressInitOK)
     inflateEnd (&m_zCompress);
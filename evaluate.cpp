@@ -294,12 +294,40 @@ string FixWildcard (const string sWildcard,       // the wildcard
   return sResult;
   } // end of FixWildcard
 
+// puts a matched wildcard into sResult, fixing it as above
+//  - this reuses sResult's buffer, so for the common case (not sent to script)
+//    nothing is allocated once the wildcards have been used a few times
+
+static void AssignWildcard (string & sResult,              // where it goes
+                            const t_regexp * regexp,       // what matched
+                            const int iNumber,             // which wildcard
+                            const bool bMakeLowerCase,     // true to make lower case
+                            const int iSendTo,             // where it is going to
+                            const CString & strLanguage)   // what script language
+  {
+const char * pStart;
+int iLength;
+
+  regexp->GetWildcardView (iNumber, pStart, iLength);
+  sResult.assign (pStart, iLength);
+
+  // force to lower-case if that is what they want
+  if (bMakeLowerCase)
+    transform (sResult.begin (), sResult.end (), sResult.begin (), (int(*)(int)) tolower);
+
+  // escaping needs a copy anyway
+  if (iSendTo == eSendToScript || iSendTo == eSendToScriptAfterOmit)
+    sResult = FixWildcard (sResult, false, iSendTo, strLanguage);
+
+  } // end of AssignWildcard
+
 
 CTrigger * CMUSHclientDoc::EvaluateTrigger (const CString & input, 
                                             CString & output,
                                             int & iItem,  // which one to start with
                                             int & iStartCol,
-                                            int & iEndCol)
+                                            int & iEndCol,
+                                            const unsigned long iPrefilterScan)
   {          
 //  timer t ("EvaluateTrigger");
 
@@ -325,6 +353,17 @@ int iCount = GetTriggerArray ().GetSize ();    // how many there are
     if (!trigger_item->bEnabled)
       continue;   // ignore non-enabled triggers
 
+    // skip if the literal text it needs is not in the line
+    if (!GetTriggerPrefilter ().IsCandidate (iItem, trigger_item, iPrefilterScan))
+      {
+      m_iTriggersPrefilteredCount++;
+      continue;
+      }
+
+    // compile it now, if that was put off when it was loaded
+    if (trigger_item->bCompilePending && trigger_item->regexp == NULL)
+      CompileTriggerRegexp (trigger_item);
+
     m_iTriggersEvaluatedCount++;  // count evaluations
 
     // do regular expression, if available
@@ -367,10 +406,18 @@ int iCount = GetTriggerArray ().GetSize ();    // how many there are
 
   Note, non-existent and empty variables will be silently dropped.
 
+  The expansion is only redone when a variable the match text uses has changed
+  (see NoteVariableChanged), or the expression was recompiled elsewhere (eg. by
+  SetTriggerOption), and the expression is only recompiled if the expanded
+  text is actually different.
+
   */
 
       if (trigger_item->bExpandVariables &&
-          trigger_item->trigger.Find ('@') != -1)
+          trigger_item->trigger.Find ('@') != -1 &&
+          (trigger_item->bMatchNeedsExpanding ||
+           trigger_item->regexp == NULL ||
+           trigger_item->regexp->m_iSerial != trigger_item->iExpandedRegexpSerial))
         {
         CString strOutput = FixSendText (trigger_item->trigger, 
                                         trigger_item->iSendTo,
@@ -384,52 +431,64 @@ int iCount = GetTriggerArray ().GetSize ();    // how many there are
                                         false,         // don't throw exceptions
                                         NULL);    // no name substitution in match text
 
+        // remember which variables it used, so we know when to do this again
+        trigger_item->bMatchNeedsExpanding = false;
+        NoteTriggerVariables (trigger_item);
 
-        LONGLONG iOldTimeTaken = 0;
-        long iOldMatchAttempts = 0;
+        if (strOutput != trigger_item->strExpandedMatch ||
+            trigger_item->regexp == NULL ||
+            trigger_item->regexp->m_iSerial != trigger_item->iExpandedRegexpSerial)
+          {
+          LONGLONG iOldTimeTaken = 0;
+          long iOldMatchAttempts = 0;
 
 
-        // remember time taken to execute them
+          // remember time taken to execute them
 
-        if (trigger_item->regexp)
-          {
-          iOldTimeTaken = trigger_item->regexp->iTimeTaken;
-          iOldMatchAttempts = trigger_item->regexp->m_iMatchAttempts;
-          }
+          if (trigger_item->regexp)
+            {
+            iOldTimeTaken = trigger_item->regexp->iTimeTaken;
+            iOldMatchAttempts = trigger_item->regexp->m_iMatchAttempts;
+            }
 
-        delete trigger_item->regexp;    // get rid of earlier regular expression
-        trigger_item->regexp = NULL;
+          delete trigger_item->regexp;    // get rid of earlier regular expression
+          trigger_item->regexp = NULL;
 
-      // all triggers are now regular expressions
+        // all triggers are now regular expressions
 
-        CString strRegexp; 
+          CString strRegexp; 
 
-        if (trigger_item->bRegexp)
-          strRegexp = strOutput;
-        else
-          strRegexp = ConvertToRegularExpression (strOutput);
+          if (trigger_item->bRegexp)
+            strRegexp = strOutput;
+          else
+            strRegexp = ConvertToRegularExpression (strOutput);
 
-        try
-          {
-          trigger_item->regexp = regcomp (strRegexp,
-                                          (trigger_item->ignore_case  ? PCRE_CASELESS : 0) |
-                                          (trigger_item->bMultiLine  ? PCRE_MULTILINE : 0) |
-                                          (m_bUTF_8 ? PCRE_UTF8 : 0)
-                                         );
-          } // end of try
-    	  catch(CException* e)
-          {
-          e->ReportError ();
-          e->Delete ();
-          continue;
-          }   // end of catch
+          try
+            {
+            trigger_item->regexp = regcomp (strRegexp,
+                                            (trigger_item->ignore_case  ? PCRE_CASELESS : 0) |
+                                            (trigger_item->bMultiLine  ? PCRE_MULTILINE : 0) |
+                                            (m_bUTF_8 ? PCRE_UTF8 : 0)
+                                           );
+            } // end of try
+    	    catch(CException* e)
+            {
+            e->ReportError ();
+            e->Delete ();
+            continue;
+            }   // end of catch
 
-        // add back execution time
-        if (trigger_item->regexp)
-          {
-          trigger_item->regexp->iTimeTaken += iOldTimeTaken;
-          trigger_item->regexp->m_iMatchAttempts += iOldMatchAttempts;
-          }
+          // add back execution time
+          if (trigger_item->regexp)
+            {
+            trigger_item->regexp->iTimeTaken += iOldTimeTaken;
+            trigger_item->regexp->m_iMatchAttempts += iOldMatchAttempts;
+
+            // this is what we compiled it from
+            trigger_item->strExpandedMatch = strOutput;
+            trigger_item->iExpandedRegexpSerial = trigger_item->regexp->m_iSerial;
+            }
+          } // end of expanded text changed
 
         } // end of variable substitution
 
@@ -449,18 +508,17 @@ int iCount = GetTriggerArray ().GetSize ();    // how many there are
       iStartCol = trigger_item->regexp->m_vOffsets [0];
       iEndCol   = trigger_item->regexp->m_vOffsets [1];
 
-      trigger_item->wildcards.clear ();
+      trigger_item->wildcards.resize (MAX_WILDCARDS);
 
       for (int iWildcard = 0; 
            iWildcard < MAX_WILDCARDS; 
            iWildcard++)
-        trigger_item->wildcards.push_back 
-                        (
-                        FixWildcard (trigger_item->regexp->GetWildcard (iWildcard),
-                                     trigger_item->bLowercaseWildcard,
-                                     trigger_item->iSendTo,
-                                     m_strLanguage)
-                        );
+        AssignWildcard (trigger_item->wildcards [iWildcard],
+                        trigger_item->regexp,
+                        iWildcard,
+                        trigger_item->bLowercaseWildcard,
+                        trigger_item->iSendTo,
+                        m_strLanguage);
           
       }
     else
@@ -477,13 +535,15 @@ int iCount = GetTriggerArray ().GetSize ();    // how many there are
     if (pLabel [0] == 0)
        pLabel = GetTriggerRevMap () [trigger_item].c_str ();
 
-    output += FixSendText (::FixupEscapeSequences (trigger_item->contents), 
+    // parsed once, unless the contents change
+    trigger_item->SendTemplate.Update (trigger_item->contents, 
+                                       trigger_item->bExpandVariables != 0);
+
+    output += ExpandSendText (trigger_item->SendTemplate, 
                             trigger_item->iSendTo,    // where it is going
                             trigger_item->regexp,     // regexp
                             GetLanguage (),           // eg. vbscript
                             trigger_item->bLowercaseWildcard,    // lower-case wildcards
-                            trigger_item->bExpandVariables,     // expand variables
-                            true,      // expand wildcards
                             false,     // convert regexps
                             false,     // is it regexp or normal?
                             false,         // don't throw exceptions
@@ -827,6 +887,13 @@ bool CMUSHclientDoc::ProcessOneAliasSequence (const CString strCurrentLine,
     if (!alias_item->bEnabled)
       continue;
 
+    // compile it now, if that was put off when it was loaded
+    if (alias_item->bCompilePending && alias_item->regexp == NULL)
+      CompileAliasRegexp (alias_item);
+
+    if (alias_item->regexp == NULL)
+      continue;   // could not compile it
+
     m_iAliasesEvaluatedCount++;
 
     BOOL bMatched;
@@ -864,18 +931,17 @@ bool CMUSHclientDoc::ProcessOneAliasSequence (const CString strCurrentLine,
     if (alias_item->bOmitFromCommandHistory)
       m_bOmitFromCommandHistory = true;
 
-    alias_item->wildcards.clear ();
+    alias_item->wildcards.resize (MAX_WILDCARDS);
 
     for (int iWildcard = 0; 
          iWildcard < MAX_WILDCARDS; 
          iWildcard++)
-      alias_item->wildcards.push_back 
-                      (
-                      FixWildcard (alias_item->regexp->GetWildcard (iWildcard),
-                                   false,
-                                   alias_item->iSendTo,
-                                   m_strLanguage)
-                      );
+      AssignWildcard (alias_item->wildcards [iWildcard],
+                      alias_item->regexp,
+                      iWildcard,
+                      false,
+                      alias_item->iSendTo,
+                      m_strLanguage);
 
   // echo the alias they typed, unless command echo off, or previously displayed
       // (if wanted - v3.38)
@@ -917,13 +983,15 @@ bool CMUSHclientDoc::ProcessOneAliasSequence (const CString strCurrentLine,
 
     try
       {
-      strSendText = FixSendText (::FixupEscapeSequences (alias_item->contents), 
+      // parsed once, unless the contents change
+      alias_item->SendTemplate.Update (alias_item->contents, 
+                                       alias_item->bExpandVariables != 0);
+
+      strSendText = ExpandSendText (alias_item->SendTemplate, 
                               alias_item->iSendTo,    // where it is going
                               alias_item->regexp,     // regexp
                               GetLanguage (),           // eg. vbscript
                               false,    // lower-case wildcards
-                              alias_item->bExpandVariables,     // expand variables
-                              true,      // expand wildcards
                               false,     // convert regexps
                               false,     // is it regexp or normal?
                               true,         // throw exceptions
@@ -1105,12 +1173,69 @@ CString CMUSHclientDoc::FixSendText (const CString strSource,
                                      const bool bThrowExceptions,   // throw exception on error
                                      const char * sName)            // the name of the trigger/timer/alias (for %N)
   {
-CString strOutput;   // result of expansion
+CSendTemplate SendTemplate;
+
+  SendTemplate.Compile (strSource, strSource, bExpandVariables, bExpandWildcards);
+
+  return ExpandSendText (SendTemplate,
+                         iSendTo,
+                         regexp,
+                         sLanguage,
+                         bMakeWildcardsLower,
+                         bFixRegexps,
+                         bIsRegexp,
+                         bThrowExceptions,
+                         sName);
+  } // end of  CMUSHclientDoc::FixSendText
+
+
+// adds literal text to the template, joining it to any literal text before it
+
+void CSendTemplate::AddLiteral (const char * pText, const int iLength)
+  {
+  if (iLength <= 0)
+    return;
+
+  m_iLiteralLength += iLength;
 
+  if (!m_vItems.empty () && m_vItems.back ().iType == eLiteral)
+    {
+    m_vItems.back ().strText += CString (pText, iLength);
+    return;
+    }
+
+  tItem item;
+  item.iType = eLiteral;
+  item.strText = CString (pText, iLength);
+  item.iNumber = 0;
+  item.bEscape = false;
+  m_vItems.push_back (item);
+  } // end of CSendTemplate::AddLiteral
+
+// Breaks send text up into items (see the list above FixSendText). Anything not
+// recognised as a variable or wildcard is literal text.
+
+void CSendTemplate::Compile (const CString & strSource,
+                             const CString & strText,
+                             const bool bExpandVariables,
+                             const bool bExpandWildcards)
+  {
 const char * pText,
-           * pStartOfGroup;
+           * pStartOfGroup,
+           * pName;
+tItem item;
 
-  pText = pStartOfGroup = strSource;
+  m_vItems.clear ();
+  m_iLiteralLength = 0;
+  m_strSource = strSource;
+  m_bExpandVariables = bExpandVariables;
+  m_bExpandWildcards = bExpandWildcards;
+  m_bCompiled = true;
+
+  item.iNumber = 0;
+  item.bEscape = false;
+
+  pText = pStartOfGroup = strText;
 
   while (*pText)
     {
@@ -1118,41 +1243,34 @@ const char * pText,
       {
 
 /* -------------------------------------------------------------------- *
- *  Variable expansion - @foo becomes <contents of foo>                 *
+ *  Variable - @foo, @!foo, or @@ for @                                 *
  * -------------------------------------------------------------------- */
 
       case '@':
-        {
         if (!bExpandVariables)
           {
           pText++;      // just copy the @
           break;
           }
 
-
-       // copy up to the @ sign
-
-        strOutput += CString (pStartOfGroup, pText - pStartOfGroup);
-      
+        AddLiteral (pStartOfGroup, pText - pStartOfGroup);
         pText++;    // skip the @
 
         // @@ becomes @
         if (*pText == '@')
           {
           pStartOfGroup = ++pText;
-          strOutput += "@";
+          AddLiteral ("@", 1);
           continue;
           }
 
-        const char * pName;
-        bool bEscape = bFixRegexps;
+        item.bEscape = true;
 
         // syntax @!variable defeats the escaping
-
         if (*pText == '!')
           {
           pText++;
-          bEscape = false;
+          item.bEscape = false;
           }
 
         pName = pText;
@@ -1164,282 +1282,527 @@ const char * pText,
           else
             break;
 
+        item.iType = eVariable;
+        item.strText = CString (pName, pText - pName);
+        item.strText.MakeLower ();
+        m_vItems.push_back (item);
+
+        // get ready for next batch from beyond the variable
+        pStartOfGroup = pText;
+        break;    // end of '@'
+
 /* -------------------------------------------------------------------- *
- *  We have a variable - look it up and do internal replacements        *
+ *  Wildcard - %1, %<foo>, %C, %N, or %% for %                          *
  * -------------------------------------------------------------------- */
-          
-        CString strVariableName (pName, pText - pName);
 
-        if (strVariableName.IsEmpty ())
-          {
-          if (bThrowExceptions)
-            ThrowErrorException ("@ must be followed by a variable name");
-          } // end of no variable name
-        else
+      case '%':
+        if (!bExpandWildcards)
           {
-          CVariable * variable_item;
+          pText++;      // just copy the %
+          break;
+          }
 
-          strVariableName.MakeLower ();
+        // see what comes after the % symbol
+        switch (pText [1])
+           {
+           case '%':
+            // copy up to - and including - the percent sign
+             AddLiteral (pStartOfGroup, pText - pStartOfGroup + 1);
+             pText += 2;    // don't reprocess the %%
+             pStartOfGroup = pText;  
+             break;   // end of %%
 
-          if (GetVariableMap ().Lookup (strVariableName, variable_item))
-            {
-            // fix up so regexps don't get confused with [ etc. inside variable
-            CString strVariableContents;
-            if (bEscape)
-              {
-              const char * pi;
-              // allow for doubling in size, plus terminating null
-              char * po = strVariableContents.GetBuffer ((variable_item->strContents.GetLength () * 2) + 1);
-              for (pi = variable_item->strContents;
-                  *pi;
-                  pi++)
-                {
-                if (((unsigned char) *pi) < ' ')
-                  continue;   // drop non-printables
-                if (bIsRegexp)
-                  if (!isalnum ((unsigned char) *pi) && *pi != ' ')
-                    {
-                    *po++ = '\\'; // escape it
-                    *po++ = *pi;
-                    }
-                  else
-                    *po++ = *pi;    // just copy it
-                else          // not regexp
-                  if (*pi != '*')
-                    *po++ = *pi;    // copy all except asterisks
-                }
+           case '0':       // a digit?
+           case '1':
+           case '2':
+           case '3':
+           case '4':
+           case '5':
+           case '6':
+           case '7':
+           case '8':
+           case '9':
+             AddLiteral (pStartOfGroup, pText - pStartOfGroup);
+             item.iType = eWildcard;
+             item.iNumber = pText [1] - '0';
+             item.strText.Empty ();
+             m_vItems.push_back (item);
+             pText += 2;
+             pStartOfGroup = pText;
+             break;   // end of %(digit) (eg. %2)
 
-              *po = 0;  // terminating null
-              strVariableContents.ReleaseBuffer (-1); 
-              }  // end of escaping wanted
-            else
-              strVariableContents = variable_item->strContents;
-
-            // in the "send" box may need to convert script expansions etc.
-            if (!bFixRegexps)
-               strVariableContents = FixWildcard ((const char *) strVariableContents,
-                                                 false, // not force variables to lowercase
-                                                 iSendTo,
-                                                 sLanguage).c_str ();
-
-            // fix up HTML sequences if we are sending it to a log file
-            if (m_bLogHTML && iSendTo == eSendToLogFile)
-              strVariableContents = FixHTMLString (strVariableContents);
-
-            strOutput += strVariableContents;
-            }   // end of name existing in variable map
-          else
-            {
-            if (bThrowExceptions)
-              ThrowErrorException ("Variable '%s' is not defined.", 
-                                  (LPCTSTR) strVariableName);
-            }  // end of variable does not exist
+           case '<':
+             AddLiteral (pStartOfGroup, pText - pStartOfGroup);
+             pText +=2;    // skip the %<
+             pName = pText;
+
+             // find end of wildcard name
+             while (*pText)
+               if (*pText != '>')
+                 pText++;
+               else
+                 break;
+
+             if (pText > pName)
+               {
+               item.strText = CString (pName, pText - pName);
+               item.iNumber = 0;
+               item.iType = eNamedWildcard;
+               if (IsStringNumber ((LPCTSTR) item.strText))
+                 {
+                 item.iType = eWildcard;     // eg. %<22>
+                 item.iNumber = atoi (item.strText);
+                 }
+               m_vItems.push_back (item);
+               }
+
+             // get ready for next batch from beyond the name
+             if (*pText == '>')
+               pText++;
+             pStartOfGroup = pText;
+             break;   // end of %<foo>
+
+           case 'C':
+           case 'c':
+             AddLiteral (pStartOfGroup, pText - pStartOfGroup);
+             item.iType = eClipboard;
+             item.strText.Empty ();
+             m_vItems.push_back (item);
+             pText += 2;
+             pStartOfGroup = pText;
+             break; // end of %c
 
-          } // end of not empty name
+           case 'N':
+           case 'n':
+             AddLiteral (pStartOfGroup, pText - pStartOfGroup);
+             item.iType = eName;
+             item.strText.Empty ();
+             m_vItems.push_back (item);
+             pText += 2;
+             pStartOfGroup = pText;
+             break; // end of %n
 
-          // get ready for next batch from beyond the variable
-          pStartOfGroup = pText;
-         }
-        break;    // end of '@'
+           default:
+              pText++;    // % followed by something else is just copied
+              break;
+
+           }  // end of switch on character after '%'
+
+         break;    // end of '%(something)'
+
+      default:
+        pText++;
+        break;
+
+      } // end of switch on *pText
+
+    }   // end of not end of string yet
+
+// copy last group
+
+  AddLiteral (pStartOfGroup, pText - pStartOfGroup);
+
+  } // end of CSendTemplate::Compile
+
+void CSendTemplate::Update (const CString & strContents, const bool bExpandVariables)
+  {
+  if (m_bCompiled &&
+      m_bExpandVariables == bExpandVariables &&
+      m_bExpandWildcards &&
+      m_strSource == strContents)
+    return;   // still good
+
+  Compile (strContents, 
+           ::FixupEscapeSequences (strContents), 
+           bExpandVariables, 
+           true);   // expand wildcards
+  } // end of CSendTemplate::Update
+
+// Expands send text parsed by CSendTemplate::Compile, into a buffer big enough
+// for the literal text, plus some room for the wildcards and variables.
+
+CString CMUSHclientDoc::ExpandSendText (const CSendTemplate & SendTemplate,
+                                        const int iSendTo,
+                                        const t_regexp * regexp,    // regular expression (for triggers, aliases)
+                                        const char * sLanguage,     // language for send-to-script
+                                        const bool bMakeWildcardsLower,
+                                        const bool bFixRegexps, // convert \ to \\ for instance
+                                        const bool bIsRegexp,   // true = regexp trigger
+                                        const bool bThrowExceptions,   // throw exception on error
+                                        const char * sName)            // the name of the trigger/timer/alias (for %N)
+  {
+string sOutput;   // result of expansion
+const char * pStart;
+int iLength;
+
+// wildcards can be copied straight from the matched text unless they need fixing
+const bool bFixWildcards = bMakeWildcardsLower ||
+                           iSendTo == eSendToScript || 
+                           iSendTo == eSendToScriptAfterOmit ||
+                           (m_bLogHTML && iSendTo == eSendToLogFile);
+
+  sOutput.reserve (SendTemplate.m_iLiteralLength + 128);
+
+  for (vector<CSendTemplate::tItem>::const_iterator it = SendTemplate.m_vItems.begin ();
+       it != SendTemplate.m_vItems.end ();
+       it++)
+    {
+    const CSendTemplate::tItem & item = *it;
+
+    switch (item.iType)
+      {
+      case CSendTemplate::eLiteral:
+        sOutput.append ((LPCTSTR) item.strText, item.strText.GetLength ());
+        break;
 
 /* -------------------------------------------------------------------- *
  *  Wildcard substitution - %1 becomes <contents of wildcard 1>         *
  *                        - %<foo> becomes <contents of wildcard "foo"  *
- *                        - %% becomes %                                *
  * -------------------------------------------------------------------- */
 
-      case '%':
+      case CSendTemplate::eWildcard:
+      case CSendTemplate::eNamedWildcard:
+        {
+        if (!regexp)
+          break;
 
-           if (!bExpandWildcards)
+        string sWildcard;
+
+        if (item.iType == CSendTemplate::eWildcard)
+          {
+          regexp->GetWildcardView (item.iNumber, pStart, iLength);
+          if (!bFixWildcards)
             {
-            pText++;      // just copy the %
+            sOutput.append (pStart, iLength);
             break;
             }
+          sWildcard.assign (pStart, iLength);
+          }
+        else
+          sWildcard = regexp->GetWildcard (string ((LPCTSTR) item.strText));
 
-        // see what comes after the % symbol
-        switch (pText [1])
-           {
+        CString strWildcard = FixWildcard (sWildcard,
+                                           bMakeWildcardsLower,
+                                           iSendTo,
+                                           sLanguage).c_str ();
+
+        // fix up HTML sequences if we are sending it to a log file
+        if (m_bLogHTML && iSendTo == eSendToLogFile)
+          strWildcard = FixHTMLString (strWildcard);
+
+        sOutput.append ((LPCTSTR) strWildcard, strWildcard.GetLength ());
+        }
+        break;  // end of wildcard
 
 /* -------------------------------------------------------------------- *
- *  %%                                                                  *
+ *  Variable expansion - @foo becomes <contents of foo>                 *
  * -------------------------------------------------------------------- */
 
-           case '%':
+      case CSendTemplate::eVariable:
+        {
+        if (item.strText.IsEmpty ())
+          {
+          if (bThrowExceptions)
+            ThrowErrorException ("@ must be followed by a variable name");
+          break;
+          } // end of no variable name
 
-          // copy up to - and including - the percent sign
+        CVariable * variable_item;
 
-            strOutput += CString (pStartOfGroup, pText - pStartOfGroup + 1);
+        if (!GetVariableMap ().Lookup (item.strText, variable_item))
+          {
+          if (bThrowExceptions)
+            ThrowErrorException ("Variable '%s' is not defined.", 
+                                (LPCTSTR) item.strText);
+          break;
+          }  // end of variable does not exist
 
-            // get ready for next batch from beyond the %%
+        // fix up so regexps don't get confused with [ etc. inside variable
+        CString strVariableContents;
+        if (bFixRegexps && item.bEscape)
+          {
+          const char * pi;
+          // allow for doubling in size, plus terminating null
+          char * po = strVariableContents.GetBuffer ((variable_item->strContents.GetLength () * 2) + 1);
+          for (pi = variable_item->strContents;
+              *pi;
+              pi++)
+            {
+            if (((unsigned char) *pi) < ' ')
+              continue;   // drop non-printables
+            if (bIsRegexp)
+              if (!isalnum ((unsigned char) *pi) && *pi != ' ')
+                {
+                *po++ = '\\'; // escape it
+                *po++ = *pi;
+                }
+              else
+                *po++ = *pi;    // just copy it
+            else          // not regexp
+              if (*pi != '*')
+                *po++ = *pi;    // copy all except asterisks
+            }
+
+          *po = 0;  // terminating null
+          strVariableContents.ReleaseBuffer (-1); 
+          }  // end of escaping wanted
+        else
+          strVariableContents = variable_item->strContents;
 
-            pText += 2;    // don't reprocess the %%
-            pStartOfGroup = pText;  
-            break;   // end of %%
+        // in the "send" box may need to convert script expansions etc.
+        if (!bFixRegexps)
+           strVariableContents = FixWildcard ((const char *) strVariableContents,
+                                             false, // not force variables to lowercase
+                                             iSendTo,
+                                             sLanguage).c_str ();
+
+        // fix up HTML sequences if we are sending it to a log file
+        if (m_bLogHTML && iSendTo == eSendToLogFile)
+          strVariableContents = FixHTMLString (strVariableContents);
+
+        sOutput.append ((LPCTSTR) strVariableContents, strVariableContents.GetLength ());
+        }
+        break;    // end of variable
 
 /* -------------------------------------------------------------------- *
- *  %0 to %9                                                            *
+ *  %C - clipboard contents                                             *
  * -------------------------------------------------------------------- */
-          
-           case '0':       // a digit?
-           case '1':
-           case '2':
-           case '3':
-           case '4':
-           case '5':
-           case '6':
-           case '7':
-           case '8':
-           case '9':
-             {
 
-            // copy up to the percent sign
+      case CSendTemplate::eClipboard:
+        {
+        CString strClipboard;
 
-              strOutput += CString (pStartOfGroup, pText - pStartOfGroup);
-                    
-            // output the appropriate replacement text
+        if (GetClipboardContents (strClipboard, m_bUTF_8))
+          sOutput.append ((LPCTSTR) strClipboard, strClipboard.GetLength ());
+        else
+          if (bThrowExceptions)
+            ThrowErrorException ("No text on the Clipboard");
+        }
+        break; // end of %c
 
-            if (regexp)
-              {
-              CString strWildcard = FixWildcard (regexp->GetWildcard (string (1, *++pText)),
-                                                 bMakeWildcardsLower,
-                                                 iSendTo,
-                                                 sLanguage).c_str ();
+/* -------------------------------------------------------------------- *
+ *  %N - name of the thing                                              *
+ * -------------------------------------------------------------------- */
 
-              // fix up HTML sequences if we are sending it to a log file
-              if (m_bLogHTML && iSendTo == eSendToLogFile)
-                strWildcard = FixHTMLString (strWildcard);
+      case CSendTemplate::eName:
+        if (sName)
+          sOutput += sName;
+        break; // end of %n
 
-              strOutput += strWildcard;
-              }
+      } // end of switch on item type
 
-            // get ready for next batch from beyond the digit
+    }   // end of for each item
 
-             pStartOfGroup = ++pText;
+  return CString (sOutput.c_str (), sOutput.size ());
+  } // end of  CMUSHclientDoc::ExpandSendText
 
+// remember which variables a trigger's match text uses (eg. @target) so it is
+// only expanded again when one of them changes
 
-             } 
-             break;   // end of %(digit) (eg. %2)
+void CMUSHclientDoc::NoteTriggerVariables (CTrigger * trigger_item)
+  {
+const char * p = trigger_item->trigger;
+const string sTriggerName = (const char *) trigger_item->strInternalName;
 
-/* -------------------------------------------------------------------- *
- *  %<name>                                                             *
- * -------------------------------------------------------------------- */
+  while ((p = strchr (p, '@')) != NULL)
+    {
+    p++;    // skip the @
 
-           case '<':
-             {
-            // copy up to the % sign
+    // @@ becomes @
+    if (*p == '@')
+      {
+      p++;
+      continue;
+      }
 
-              strOutput += CString (pStartOfGroup, pText - pStartOfGroup);
-    
-              pText +=2;    // skip the %<
+    // @!variable defeats the escaping
+    if (*p == '!')
+      p++;
 
-              const char * pName = pText;
+    const char * pName = p;
 
-              // find end of wildcard name
-              while (*pText)
-                if (*pText != '>')
-                  pText++;
-                else
-                  break;
-  
-              string sWildcardName (pName, pText - pName);
+    // find end of variable name (same rules as FixSendText)
+    while (*p == '_' || isalnum ((unsigned char) *p))
+      p++;
 
-              if (!sWildcardName.empty () && regexp)
-                {
-                CString strWildcard = FixWildcard (regexp->GetWildcard (sWildcardName),
-                                                   bMakeWildcardsLower,
-                                                   iSendTo,
-                                                   sLanguage).c_str ();
+    if (p > pName)
+      GetVariableDependencies () [tolower (string (pName, p - pName))].insert (sTriggerName);
+    }   // end of finding each @
 
-                // fix up HTML sequences if we are sending it to a log file
-                if (m_bLogHTML && iSendTo == eSendToLogFile)
-                  strWildcard = FixHTMLString (strWildcard);
+  } // end of CMUSHclientDoc::NoteTriggerVariables
 
-                strOutput += strWildcard;
+// a variable was set or deleted - any triggers (in the current plugin) whose 
+// match text uses it must be expanded again before they are next evaluated
 
-                }
-              // get ready for next batch from beyond the name
+void CMUSHclientDoc::NoteVariableChanged (const CString & strVariableName)
+  {
+CString strName = strVariableName;
 
-              if (*pText == '>')
-                pText++;
-              pStartOfGroup = pText;
-             }
-             break;   // end of %<foo>
+  strName.MakeLower ();
 
-/* -------------------------------------------------------------------- *
- *  %C - clipboard contents                                             *
- * -------------------------------------------------------------------- */
+  CVariableDependencyMap::iterator it = GetVariableDependencies ().find ((const char *) strName);
 
-           case 'C':
-           case 'c':
-             {
-            // copy up to the percent sign
-              strOutput += CString (pStartOfGroup, pText - pStartOfGroup);
+  if (it == GetVariableDependencies ().end ())
+    return;   // no trigger cares
 
-              CString strClipboard;
+  for (set<string>::const_iterator i = it->second.begin (); i != it->second.end (); i++)
+    {
+    CTrigger * trigger_item;
+    // it may have been deleted since
+    if (GetTriggerMap ().Lookup (i->c_str (), trigger_item))
+      trigger_item->bMatchNeedsExpanding = true;
+    }
 
-              if (GetClipboardContents (strClipboard, m_bUTF_8))
-                strOutput += strClipboard;
-              else
-                if (bThrowExceptions)
-                  ThrowErrorException ("No text on the Clipboard");
+  // they will be noted again when they are expanded
+  GetVariableDependencies ().erase (it);
 
-        // get ready for next batch from beyond the 'c'
+  } // end of CMUSHclientDoc::NoteVariableChanged
 
-              pText += 2;
-              pStartOfGroup = pText;
-             }
-             break; // end of %c
+// variables changed in some way we can't track (eg. the configuration dialog) -
+// expand all triggers (in the current plugin) again
 
-/* -------------------------------------------------------------------- *
- *  %N - name of the thing                                              *
- * -------------------------------------------------------------------- */
+void CMUSHclientDoc::NoteAllVariablesChanged (void)
+  {
+CString strTriggerName;
+CTrigger * trigger_item;
 
-           case 'N':
-           case 'n':
-             {
-            // copy up to the percent sign
-              strOutput += CString (pStartOfGroup, pText - pStartOfGroup);
+  for (POSITION pos = GetTriggerMap ().GetStartPosition (); pos; )
+    {
+    GetTriggerMap ().GetNextAssoc (pos, strTriggerName, trigger_item);
+    trigger_item->bMatchNeedsExpanding = true;
+    }
 
-              if (sName)
-                strOutput += sName;
+  GetVariableDependencies ().clear ();
 
-        // get ready for next batch from beyond the 'n'
+  } // end of CMUSHclientDoc::NoteAllVariablesChanged
 
-              pText += 2;
-              pStartOfGroup = pText;
-             }
-             break; // end of %n
+/*
 
-/* -------------------------------------------------------------------- *
- *  %(something else)                                                   *
- * -------------------------------------------------------------------- */
+  When a world or plugin is loaded we only check that each trigger and alias
+  will compile. Studying (and JIT-compiling) them is left until they are first
+  evaluated - so disabled ones cost nothing - or until the world is idle,
+  when CheckTimers compiles a few at a time (CompilePendingRegexps).
 
-           default:
-              pText++;
-              break;
+*/
 
-           }  // end of switch on character after '%'
+void CMUSHclientDoc::CompileTriggerRegexp (CTrigger * trigger_item)
+  {
+CString strRegexp; 
 
-         break;    // end of '%(something)'
+  trigger_item->bCompilePending = false;
+  if (m_iRegexpsPending > 0)
+    m_iRegexpsPending--;
 
-/* -------------------------------------------------------------------- *
- *  All other characters - just increment pointer so we can copy later  *
- * -------------------------------------------------------------------- */
+  // all triggers are now regular expressions
 
-      default:
-        pText++;
-        break;
+  if (trigger_item->bRegexp)
+    strRegexp = trigger_item->trigger;
+  else
+    strRegexp = ConvertToRegularExpression (trigger_item->trigger);
 
-      } // end of switch on *pText
+  try
+    {
+    trigger_item->regexp = regcomp (strRegexp,
+                                    (trigger_item->ignore_case  ? PCRE_CASELESS : 0) |
+                                    (trigger_item->bMultiLine  ? PCRE_MULTILINE : 0) |
+                                    (m_bUTF_8 ? PCRE_UTF8 : 0)
+                                   );
+    } // end of try
+  catch(CException* e)
+    {
+    e->ReportError ();
+    e->Delete ();
+    return;
+    }   // end of catch
 
-    }   // end of not end of string yet
+  // the prefilter can now use the literal text it needs
+  if (!trigger_item->regexp->m_sRequiredLiteral.empty ())
+    GetTriggerPrefilter ().Invalidate ();
 
-// copy last group
+  } // end of CMUSHclientDoc::CompileTriggerRegexp
+
+void CMUSHclientDoc::CompileAliasRegexp (CAlias * alias_item)
+  {
+CString strRegexp; 
 
-  strOutput += pStartOfGroup;
+  alias_item->bCompilePending = false;
+  if (m_iRegexpsPending > 0)
+    m_iRegexpsPending--;
 
-  return strOutput;
-  } // end of  CMUSHclientDoc::FixSendText
+  // all aliases are now regular expressions
+
+  if (alias_item->bRegexp)
+    strRegexp = alias_item->name;
+  else
+    strRegexp = ConvertToRegularExpression (alias_item->name);
+
+  try
+    {
+    alias_item->regexp = regcomp (strRegexp, (alias_item->bIgnoreCase ? PCRE_CASELESS : 0)
+#if ALIASES_USE_UTF8
+                                  | (m_bUTF_8 ? PCRE_UTF8 : 0)
+#endif // ALIASES_USE_UTF8
+                                 );
+    } // end of try
+  catch(CException* e)
+    {
+    e->ReportError ();
+    e->Delete ();
+    }   // end of catch
+
+  } // end of CMUSHclientDoc::CompileAliasRegexp
+
+// compile up to iMaximum of the deferred regular expressions, in the world
+// and then each plugin
+
+void CMUSHclientDoc::CompilePendingRegexps (const int iMaximum)
+  {
+CPlugin * pSavedPlugin = m_CurrentPlugin;
+PluginListIterator pit = m_PluginList.begin ();
+int iCompiled = 0;
+CString strName;
+CTrigger * trigger_item;
+CAlias * alias_item;
+POSITION pos;
+
+  m_CurrentPlugin = NULL;   // world first
+
+  while (true)
+    {
+    for (pos = GetTriggerMap ().GetStartPosition (); pos && iCompiled < iMaximum; )
+      {
+      GetTriggerMap ().GetNextAssoc (pos, strName, trigger_item);
+      if (trigger_item->bCompilePending && trigger_item->regexp == NULL)
+        {
+        CompileTriggerRegexp (trigger_item);
+        iCompiled++;
+        }
+      } // end of each trigger
+
+    for (pos = GetAliasMap ().GetStartPosition (); pos && iCompiled < iMaximum; )
+      {
+      GetAliasMap ().GetNextAssoc (pos, strName, alias_item);
+      if (alias_item->bCompilePending && alias_item->regexp == NULL)
+        {
+        CompileAliasRegexp (alias_item);
+        iCompiled++;
+        }
+      } // end of each alias
+
+    if (iCompiled >= iMaximum || pit == m_PluginList.end ())
+      break;
+
+    m_CurrentPlugin = *pit++;   // now the next plugin
+    } // end of world and each plugin
+
+  m_CurrentPlugin = pSavedPlugin;
+
+  // the count is only a guide (deleted triggers are not taken off it) - if
+  // we went right through without finding enough, there are none left
+  if (iCompiled < iMaximum)
+    m_iRegexpsPending = 0;
+
+  } // end of CMUSHclientDoc::CompilePendingRegexps
 
 
 #ifdef PANE
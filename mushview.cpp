@@ -3247,24 +3247,9 @@ void CMUSHView::AutoWrapWindowWidth (CMUSHclientDoc* pDoc)
   // We must adjust the current line to allow for the new wrap size
 
     if (pDoc->m_pCurrentLine)     // a new world might not have a line yet
-      {
-      // save current line text
-      CString strLine = CString (pDoc->m_pCurrentLine->text, pDoc->m_pCurrentLine->len);
-
-  #ifdef USE_REALLOC
-      pDoc->m_pCurrentLine->text  = (char *) realloc (pDoc->m_pCurrentLine->text, 
-                                               MAX (pDoc->m_pCurrentLine->len, iWidth) 
-                                               * sizeof (char));
-  #else
-      delete [] pDoc->m_pCurrentLine->text;
-      pDoc->m_pCurrentLine->text = new char [MAX (pDoc->m_pCurrentLine->len, iWidth)];
-  #endif
-
-      // put text back
-      memcpy (pDoc->m_pCurrentLine->text, (LPCTSTR) strLine, pDoc->m_pCurrentLine->len);
-      ASSERT (pDoc->m_pCurrentLine->text);
-    
-      }   // end of having a current line
+      pDoc->m_pCurrentLine->ResizeText (pDoc->m_TextArena,
+                                        MAX (pDoc->m_pCurrentLine->len, iWidth) * 
+                                        (pDoc->m_bUTF_8 ? 4 : 1));
 
     pDoc->m_nWrapColumn = iWidth;
 
@@ -41,7 +41,8 @@ void CMUSHclientDoc::MXP_collected_element (void)
 
 //  TRACE1 ("MXP collected element: <%s>\n", (LPCTSTR) m_strMXPstring);
 
-  MXP_error (DBG_ALL, msgMXP_CollectedElement,
+  if (!MXP_SuppressMessage (DBG_ALL, msgMXP_CollectedElement))
+    MXP_error (DBG_ALL, msgMXP_CollectedElement,
               TFormat ("MXP element: <%s>", 
               (LPCTSTR) m_strMXPstring)); 
 
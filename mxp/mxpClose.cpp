@@ -223,6 +223,8 @@ bool bHaveVariable = false;
     variable_item->strLabel = strVariable;
     variable_item->strContents = strText;
 
+    NoteVariableChanged (strVariable);    // we are not in a plugin here
+
     // call script if required
     if (m_dispidOnMXP_SetVariable != DISPID_UNKNOWN)
       {
@@ -283,7 +285,7 @@ bool bHaveVariable = false;
 
     if (strTag == "var"|| strTag == "v") // add entity to map
       {
-      m_CustomEntityMap.SetAt (strVariable, strText);
+      MXP_SetCustomEntity (strVariable, strText);
 
       // tell each plugin what we have received
       if (m_bPluginProcessesSetEntity)
@@ -84,7 +84,8 @@ CString strName;
 */
 
   // debugging
-  MXP_error (DBG_INFO, msgMXP_GotDefinition,
+  if (!MXP_SuppressMessage (DBG_INFO, msgMXP_GotDefinition))
+    MXP_error (DBG_INFO, msgMXP_GotDefinition,
               TFormat ("Got Definition: !%s %s %s", 
                       (LPCTSTR) strDefinition, 
                       (LPCTSTR) strName,
@@ -410,7 +411,7 @@ void CMUSHclientDoc::MXP_Entity (CString strName, CString strTag)
 
     // blank contents deletes the entity
   if (strEntityContents.IsEmpty ())
-     m_CustomEntityMap.RemoveKey (strName);
+     MXP_RemoveCustomEntity (strName);
   else
     {
 
@@ -449,7 +450,7 @@ void CMUSHclientDoc::MXP_Entity (CString strName, CString strTag)
       } // end of processing the value
 
     // add entity to map
-    m_CustomEntityMap.SetAt (strName, strFixedValue);
+    MXP_SetCustomEntity (strName, strFixedValue);
 
     // tell each plugin what we have received
     if (m_bPluginProcessesSetEntity)
@@ -488,7 +489,7 @@ void CMUSHclientDoc::MXP_Entity (CString strName, CString strTag)
       } 
     else if (strKeyword == "delete")
       {
-      m_CustomEntityMap.RemoveKey (strName);
+      MXP_RemoveCustomEntity (strName);
       } 
     else if (strKeyword == "add")
       {
@@ -496,7 +497,7 @@ void CMUSHclientDoc::MXP_Entity (CString strName, CString strTag)
       } 
     else if (strKeyword == "remove")
       {
-      m_CustomEntityMap.RemoveKey (strName);
+      MXP_RemoveCustomEntity (strName);
       } 
     else
       {
@@ -30,11 +30,12 @@ void CMUSHclientDoc::MXP_collected_entity (void)
 
 //  TRACE1 ("MXP collected entity %s\n", (LPCTSTR) m_strMXPstring);
 
-  MXP_error (DBG_ALL, msgMXP_CollectedEntity,
+  if (!MXP_SuppressMessage (DBG_ALL, msgMXP_CollectedEntity))
+    MXP_error (DBG_ALL, msgMXP_CollectedEntity,
               TFormat ("MXP entity: &%s;", 
               (LPCTSTR) m_strMXPstring)); 
-
-  if (!IsValidName (m_strMXPstring) && m_strMXPstring.Left (1) != "#")
+  if (!IsValidName (m_strMXPstring) && 
+      (m_strMXPstring.IsEmpty () || m_strMXPstring [0] != '#'))
     {
     MXP_error (DBG_ERROR, errMXP_InvalidEntityName,
                 TFormat ("Invalid MXP entity name \"%s\" supplied.",
@@ -44,101 +45,381 @@ void CMUSHclientDoc::MXP_collected_entity (void)
 
 // see if we know of this entity
 
-CString strEntityContents = MXP_GetEntity (m_strMXPstring);
+CString strEntityContents;
+char sCharacter [8];
+int iLength;
+
+const char * p = MXP_FindEntity (m_strMXPstring, 
+                                 m_strMXPstring.GetLength (),
+                                 strEntityContents,
+                                 sCharacter,
+                                 iLength);
   
-  if (!strEntityContents.IsEmpty ())
+  if (p && iLength > 0)
     {
 //  if the entity happens to be < & > etc. don't reprocess it
     m_bMXP = false;
-    DisplayMsg (strEntityContents, strEntityContents.GetLength (), 0);
+    DisplayMsg (p, iLength, 0);
     m_bMXP = true;
     }
 
   } // end of CMUSHclientDoc::MXP_collected_entity
 
 
+// for MXP arguments and definitions, which want the entity contents as a string
 
 CString CMUSHclientDoc::MXP_GetEntity (CString & strName)
   {
+CString strEntityContents;
+char sCharacter [8];
+int iLength;
 
-CString strLowerCaseName = strName;
+const char * p = MXP_FindEntity (strName, 
+                                 strName.GetLength (), 
+                                 strEntityContents,
+                                 sCharacter,
+                                 iLength);
 
-  strLowerCaseName.MakeLower ();
+  if (p == NULL)
+    return "";
 
-CString strEntityContents;
+  if (p == sCharacter)
+    return CString (sCharacter, iLength);
+
+  return strEntityContents;
+  }  // end of CMUSHclientDoc::MXP_GetEntity 
+
+
+// Look up an entity name (without the & and ;), reporting an error if it is not known.
+//
+// Returns what it expands to, and its length, or NULL if not known. A character
+// entity (eg. &#233; or &eacute;) is built into sCharacter (which must hold 8 bytes),
+// as UTF-8 if this world is using UTF-8. Otherwise the result is the text of
+// strContents, which keeps it valid even if a script redefines the entity while
+// the caller is using it.
+
+const char * CMUSHclientDoc::MXP_FindEntity (const char * sName, 
+                                             const int iLength,
+                                             CString & strContents,
+                                             char * sCharacter, 
+                                             int & iResultLength)
+  {
+long iResult = 0;
+const CEntityTable::tEntity * pEntity;
+
+  iResultLength = 0;
 
   // look for &#nnn; 
 
-  if (strName [0] == '#')
+  if (iLength > 0 && sName [0] == '#')
     {
-    int iResult = 0;
+    int i;
 
     // validate and work out number
-    if (strName [1] == 'x')
+    if (iLength > 1 && sName [1] == 'x')
       {
-      for (int i = 2; i < strName.GetLength (); i++)
+      for (i = 2; i < iLength; i++)
         {
-        if (!isxdigit (strName [i]))
+        if (!isxdigit (sName [i]))
           {
           MXP_error (DBG_ERROR, errMXP_InvalidEntityNumber,
                     TFormat ("Invalid hex number in MXP entity: &%s;" ,
-                              (LPCTSTR) strName));
+                              (LPCTSTR) CString (sName, iLength)));
 
-          return "";
+          return NULL;
           }
 
-        int iNewDigit = toupper (strName [i]);
+        int iNewDigit = toupper (sName [i]);
         if (iNewDigit >= 'A')
           iNewDigit -= 7;
-        if (iResult & 0xF0)
+        if (!m_bUTF_8 && (iResult & 0xF0))
           {
           MXP_error (DBG_ERROR, errMXP_InvalidEntityNumber,
                     TFormat ("Invalid hex number in MXP entity: &%s;" 
                              "- maximum of 2 hex digits",
-                              (LPCTSTR) strName));
-          return "";
+                              (LPCTSTR) CString (sName, iLength)));
+          return NULL;
           }
-          iResult = (iResult << 4) + iNewDigit - '0';
+        iResult = (iResult << 4) + iNewDigit - '0';
+        if (iResult > 0x10FFFF)
+          break;    // too big for Unicode, rejected below
         }
       } // end of hex entity
     else
-      for (int i = 1; i < strName.GetLength (); i++)
+      for (i = 1; i < iLength; i++)
         {
-        if (!isdigit (strName [i]))
+        if (!isdigit (sName [i]))
           {
           MXP_error (DBG_ERROR, errMXP_InvalidEntityNumber,
                     TFormat ("Invalid number in MXP entity: &%s;" ,
-                              (LPCTSTR) strName));
-          return "";
+                              (LPCTSTR) CString (sName, iLength)));
+          return NULL;
           }
         iResult *= 10;
-        iResult += strName [i] - '0';
+        iResult += sName [i] - '0';
+        if (iResult > 0x10FFFF)
+          break;    // too big for Unicode, rejected below
         }
+
     if (iResult != 9  && iResult != 10  && iResult != 13 )       // we will accept tabs, newlines and carriage-returns ;)
       if (iResult < 32 ||   // don't allow nonprintable characters
-          iResult > 255)   // don't allow characters more than 1 byte
+          (!m_bUTF_8 && iResult > 255) ||   // don't allow characters more than 1 byte
+          iResult > 0x10FFFF ||                         // or beyond Unicode
+          (iResult >= 0xD800 && iResult <= 0xDFFF))     // or UTF-16 surrogates
           {
           MXP_error (DBG_ERROR, errMXP_DisallowedEntityNumber,
                     TFormat ("Disallowed number in MXP entity: &%s;" ,
-                              (LPCTSTR) strName));
-          return "";
+                              (LPCTSTR) CString (sName, iLength)));
+          return NULL;
           }
-    unsigned char cOneCharacterLine [2] = { (unsigned char) iResult, 0};
-    return (char *) cOneCharacterLine;
     } // end of entity starting with #
-
     
-  // look up global entities first
-  if (App.m_EntityMap.Lookup (strName, strEntityContents))
-    return strEntityContents;
-  // then try ones for this document
-  else if (m_CustomEntityMap.Lookup (strLowerCaseName, strEntityContents))
-    return strEntityContents;
-
-  MXP_error (DBG_ERROR, errMXP_UnknownEntity,
-              TFormat ("Unknown MXP entity: &%s;" ,
-                        (LPCTSTR) strName));
-
-  return "";
-  }  // end of CMUSHclientDoc::MXP_GetEntity 
+  // look up global entities first (case-sensitive)
+  else if ((pEntity = App.m_EntityTable.Find (sName, iLength)) != NULL)
+    {
+    if (!m_bUTF_8 || pEntity->iCharacter < 0x80)
+      {
+      strContents = pEntity->strValue;    // shares the table's copy
+      iResultLength = strContents.GetLength ();
+      return strContents;
+      }
+    iResult = pEntity->iCharacter;    // needs converting to UTF-8
+    }
+
+  // then try ones for this document (MXP stores them in lower case)
+  else if ((pEntity = m_CustomEntityTable.FindLower (sName, iLength)) != NULL)
+    {
+    strContents = pEntity->strValue;    // shares the table's copy
+    iResultLength = strContents.GetLength ();
+    return strContents;
+    }
+
+  else
+    {
+    MXP_error (DBG_ERROR, errMXP_UnknownEntity,
+                TFormat ("Unknown MXP entity: &%s;" ,
+                          (LPCTSTR) CString (sName, iLength)));
+    return NULL;
+    }
+
+  // here for a single character
+
+  if (m_bUTF_8 && iResult >= 0x80)
+    iResultLength = _pcre_ord2utf (iResult, (unsigned char *) sCharacter);
+  else
+    {
+    sCharacter [0] = (char) iResult;
+    iResultLength = 1;
+    }
+
+  sCharacter [iResultLength] = 0;
+  return sCharacter;
+
+  }  // end of CMUSHclientDoc::MXP_FindEntity 
+
+
+// custom entities are kept in the map (for listing them) and the table (for finding them)
+
+void CMUSHclientDoc::MXP_SetCustomEntity (const CString & strName, const CString & strValue)
+  {
+  m_CustomEntityMap.SetAt (strName, strValue);
+  m_CustomEntityTable.SetAt (strName, strValue);
+  } // end of CMUSHclientDoc::MXP_SetCustomEntity
+
+void CMUSHclientDoc::MXP_RemoveCustomEntity (const CString & strName)
+  {
+  m_CustomEntityMap.RemoveKey (strName);
+  m_CustomEntityTable.RemoveKey (strName);
+  } // end of CMUSHclientDoc::MXP_RemoveCustomEntity
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CEntityTable
+
+// FNV-1a, folding case if wanted
+unsigned long CEntityTable::Hash (const char * sName, const int iLength) const
+  {
+  unsigned long iHash = 2166136261UL ^ m_iSeed;
+
+  for (int i = 0; i < iLength; i++)
+    {
+    unsigned char c = sName [i];
+    if (m_bFoldCase && c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    iHash ^= c;
+    iHash *= 16777619UL;
+    }
+
+  return iHash ^ (iHash >> 16);   // low bits pick the slot, so mix the high ones in
+  } // end of CEntityTable::Hash
+
+int CEntityTable::Search (const char * sName, const int iLength, const bool bLower) const
+  {
+  if (m_vSlots.empty () || iLength <= 0)
+    return -1;
+
+  const unsigned long iMask = m_vSlots.size () - 1;
+  unsigned long iSlot = Hash (sName, iLength) & iMask;
+
+  for (unsigned long iProbe = 0; iProbe <= iMask; iProbe++, iSlot = (iSlot + 1) & iMask)
+    {
+    const tEntity & entity = m_vSlots [iSlot];
+
+    if (entity.strName.IsEmpty ())
+      {
+      if (!entity.bDeleted)
+        return -1;    // never-used slot ends the search
+      continue;       // deleted one does not
+      }
+
+    if (entity.strName.GetLength () != iLength)
+      continue;
+
+    const char * p = entity.strName;
+    int i;
+
+    if (bLower)
+      {
+      for (i = 0; i < iLength; i++)
+        if (p [i] != tolower ((unsigned char) sName [i]))
+          break;
+      }
+    else
+      i = memcmp (p, sName, iLength) == 0 ? iLength : 0;
+
+    if (i == iLength)
+      return iSlot;
+    } // end of for each slot
+
+  return -1;
+  } // end of CEntityTable::Search
+
+const CEntityTable::tEntity * CEntityTable::Find (const char * sName, const int iLength) const
+  {
+  int iSlot = Search (sName, iLength, false);
+  return iSlot < 0 ? NULL : &m_vSlots [iSlot];
+  } // end of CEntityTable::Find
+
+const CEntityTable::tEntity * CEntityTable::FindLower (const char * sName, const int iLength) const
+  {
+  int iSlot = Search (sName, iLength, m_bFoldCase);
+  return iSlot < 0 ? NULL : &m_vSlots [iSlot];
+  } // end of CEntityTable::FindLower
+
+void CEntityTable::Insert (const tEntity & entity)
+  {
+  const unsigned long iMask = m_vSlots.size () - 1;
+  unsigned long iSlot = Hash (entity.strName, entity.strName.GetLength ()) & iMask;
+
+  // table is never more than half full, so there will be a free slot
+  while (!m_vSlots [iSlot].strName.IsEmpty ())
+    iSlot = (iSlot + 1) & iMask;
+
+  if (!m_vSlots [iSlot].bDeleted)
+    m_iUsed++;
+
+  m_vSlots [iSlot] = entity;
+  m_vSlots [iSlot].bDeleted = false;
+  m_iCount++;
+  } // end of CEntityTable::Insert
+
+void CEntityTable::Rehash (const unsigned long iSize)
+  {
+  vector<tEntity> vOld;
+
+  vOld.swap (m_vSlots);
+  m_vSlots.resize (iSize);
+  m_iCount = 0;
+  m_iUsed = 0;    // deleted slots are dropped
+
+  for (vector<tEntity>::const_iterator it = vOld.begin (); it != vOld.end (); it++)
+    if (!it->strName.IsEmpty ())
+      Insert (*it);
+  } // end of CEntityTable::Rehash
+
+void CEntityTable::SetAt (const CString & strName, const CString & strValue, const long iCharacter)
+  {
+  if (strName.IsEmpty ())
+    return;   // cannot look it up anyway
+
+  int iSlot = Search (strName, strName.GetLength (), false);
+
+  if (iSlot >= 0)
+    {
+    m_vSlots [iSlot].strValue = strValue;
+    m_vSlots [iSlot].iCharacter = iCharacter;
+    return;
+    }
+
+  // keep at least half the slots never-used, so searches stop quickly
+  if ((unsigned long) (m_iUsed + 1) * 2 > m_vSlots.size ())
+    {
+    unsigned long iSize = 16;
+    while ((unsigned long) (m_iCount + 1) * 4 > iSize)
+      iSize *= 2;
+    Rehash (iSize);
+    }
+
+  tEntity entity;
+  entity.strName = strName;
+  entity.strValue = strValue;
+  entity.iCharacter = iCharacter;
+  Insert (entity);
+  } // end of CEntityTable::SetAt
+
+void CEntityTable::RemoveKey (const CString & strName)
+  {
+  int iSlot = Search (strName, strName.GetLength (), false);
+
+  if (iSlot < 0)
+    return;
+
+  tEntity & entity = m_vSlots [iSlot];
+  entity.strName.Empty ();
+  entity.strValue.Empty ();
+  entity.iCharacter = -1;
+  entity.bDeleted = true;
+  m_iCount--;
+  } // end of CEntityTable::RemoveKey
+
+void CEntityTable::RemoveAll (void)
+  {
+  m_vSlots.clear ();
+  m_iCount = 0;
+  m_iUsed = 0;
+  } // end of CEntityTable::RemoveAll
+
+void CEntityTable::MakePerfect (void)
+  {
+  if (m_iCount == 0)
+    return;
+
+  unsigned long iSize = 16;
+  while ((unsigned long) m_iCount * 8 > iSize)
+    iSize *= 2;
+
+  // try a few seeds at each size - with 8 slots per name one is usually found quickly
+  for ( ; iSize <= 65536; iSize *= 2)
+    for (m_iSeed = 1; m_iSeed <= 1000; m_iSeed++)
+      {
+      Rehash (iSize);
+
+      const unsigned long iMask = iSize - 1;
+      unsigned long iSlot;
+
+      for (iSlot = 0; iSlot < iSize; iSlot++)
+        {
+        const CString & strName = m_vSlots [iSlot].strName;
+        if (!strName.IsEmpty () && 
+            (Hash (strName, strName.GetLength ()) & iMask) != iSlot)
+          break;    // not in its home slot
+        }
+
+      if (iSlot >= iSize)
+        return;   // perfect
+      } // end of for each seed
+
+  // still works, just not perfectly (rehash for the seed we ended up with)
+  Rehash (m_vSlots.size ());
 
+  } // end of CEntityTable::MakePerfect
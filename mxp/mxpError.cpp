@@ -36,6 +36,8 @@ char * p = "?";
   if (iLevel >= 0 && iLevel < NUMITEMS (sLevel))
     p = sLevel [iLevel];
 
+  m_MXPmessageCounts [iMessageNumber]++;
+
   if (iLevel == DBG_ERROR)
     {
     m_iMXPerrors++;
@@ -146,6 +148,25 @@ char * p = "?";
                       eNotepadMXPdebug);
   }
 
+// Call this before formatting a debugging message. If no script, plugin or debug window
+// would see it we count it as raised (as MXP_error would have) and return true, in
+// which case the caller need not bother building the message text at all.
+// Errors are never suppressed as they have side-effects (eg. cancelling secure mode).
+
+bool CMUSHclientDoc::MXP_SuppressMessage (const int iLevel, 
+                                          const long iMessageNumber)
+  {
+  if (iLevel == DBG_ERROR ||
+      iLevel <= m_iMXPdebugLevel ||
+      m_dispidOnMXP_Error != DISPID_UNKNOWN ||
+      m_bPluginProcessesError)
+    return false;     // someone wants it
+
+  m_MXPmessageCounts [iMessageNumber]++;
+  m_iMXPmessagesSuppressed++;
+  return true;
+  } // end of CMUSHclientDoc::MXP_SuppressMessage
+
 // here at an unexpected termination of element collection, eg. <blah \n
 void CMUSHclientDoc::MXP_unterminated_element (const char * pReason)
   {
@@ -127,6 +127,8 @@ void CMUSHclientDoc::MXP_On (const bool bPueblo, const bool bManual)
  m_iMXPerrors = 0;     
  m_iMXPtags = 0;       
  m_iMXPentities = 0; 
+ m_iMXPmessagesSuppressed = 0;
+ m_MXPmessageCounts.clear ();
  m_iListMode = eNoList;
  m_iListCount = 0;
 
@@ -152,6 +154,7 @@ void CMUSHclientDoc::MXP_On (const bool bPueblo, const bool bManual)
   // delete custom entities list
 
     m_CustomEntityMap.RemoveAll ();
+    m_CustomEntityTable.RemoveAll ();
    }
 
  }  // end of CMUSHclientDoc::MXP_On
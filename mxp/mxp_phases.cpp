@@ -4,6 +4,80 @@
 #include "..\MUSHclient.h"
 #include "..\doc.h"
 
+// Character classes for collecting MXP elements, comments and entities.
+
+// Each bit says that the character needs individual attention in that phase,
+// anything else is just added to m_strMXPstring. 
+
+#define MXP_CHAR_ELEMENT  0x01    // special inside <...>
+#define MXP_CHAR_COMMENT  0x02    // special inside <!-- ... -->
+#define MXP_CHAR_ENTITY   0x04    // special inside &...;
+#define MXP_CHAR_STOP     0x08    // ends any collection (see DisplayMsg)
+
+static class CMXPcharTable
+  {
+  public:
+
+  unsigned char m_iClass [256];
+
+  CMXPcharTable ()
+    {
+    ZeroMemory (m_iClass, sizeof m_iClass);
+
+    m_iClass ['>']  |= MXP_CHAR_ELEMENT | MXP_CHAR_COMMENT;
+    m_iClass ['<']  |= MXP_CHAR_ELEMENT | MXP_CHAR_ENTITY;
+    m_iClass ['\''] |= MXP_CHAR_ELEMENT;
+    m_iClass ['\"'] |= MXP_CHAR_ELEMENT;
+    m_iClass ['-']  |= MXP_CHAR_ELEMENT;
+    m_iClass [';']  |= MXP_CHAR_ENTITY;
+    m_iClass ['&']  |= MXP_CHAR_ENTITY;
+
+    m_iClass ['\r']   |= MXP_CHAR_STOP;
+    m_iClass ['\n']   |= MXP_CHAR_STOP;
+    m_iClass [0x1B]   |= MXP_CHAR_STOP;   // ESC
+    m_iClass [0xFF]   |= MXP_CHAR_STOP;   // IAC
+    }  // end of constructor
+
+  } MXPcharTable;
+
+// Collects the run of ordinary characters at p (in the current MXP phase)
+// returns how many were collected - 0 means the first one needs to be 
+// handled by the Phase_MXP_xxx routines
+
+int CMUSHclientDoc::Phase_MXP_RUN (const unsigned char * p, const int size)
+  {
+  unsigned char iMask = MXP_CHAR_STOP;
+  int iRun;
+
+  switch (m_phase)
+    {
+    case HAVE_MXP_ELEMENT:  iMask |= MXP_CHAR_ELEMENT; break;
+    case HAVE_MXP_COMMENT:  iMask |= MXP_CHAR_COMMENT; break;
+    case HAVE_MXP_ENTITY:   iMask |= MXP_CHAR_ENTITY;  break;
+    case HAVE_MXP_QUOTE:    break;    // only the closing quote matters
+    default:                return 0;
+    } // end of switch
+
+  for (iRun = 0; iRun < size; iRun++)
+    {
+    if (MXPcharTable.m_iClass [p [iRun]] & iMask)
+      break;
+    if (m_phase == HAVE_MXP_QUOTE && p [iRun] == m_cMXPquoteTerminator)
+      break;
+    }
+
+  if (iRun == 0)
+    return 0;
+
+  // add them to the string in one go
+  int iLength = m_strMXPstring.GetLength ();
+  char * pBuffer = m_strMXPstring.GetBuffer (iLength + iRun);
+  memcpy (&pBuffer [iLength], p, iRun);
+  m_strMXPstring.ReleaseBuffer (iLength + iRun);
+
+  return iRun;
+  }   // end of Phase_MXP_RUN
+
 // mxp phases
 
 void CMUSHclientDoc::Phase_MXP_ELEMENT (const unsigned char c)
@@ -33,8 +107,9 @@ void CMUSHclientDoc::Phase_MXP_ELEMENT (const unsigned char c)
         // may be a comment? check on a hyphen
     case '-':
           m_strMXPstring += c;  // collect this character
-          if (m_strMXPstring.Left (3) == "!--")
-          m_phase = HAVE_MXP_COMMENT;
+          if (m_strMXPstring.GetLength () == 3 && 
+              memcmp ((LPCTSTR) m_strMXPstring, "!--", 3) == 0)
+            m_phase = HAVE_MXP_COMMENT;
           break;
 
          // any other character, add to string
@@ -50,7 +125,8 @@ void CMUSHclientDoc::Phase_MXP_COMMENT (const unsigned char c)
     {
         // end of element
     case '>':
-        if (m_strMXPstring.Right (2) == "--")
+        if (m_strMXPstring.GetLength () >= 2 &&
+            memcmp ((LPCTSTR) m_strMXPstring + m_strMXPstring.GetLength () - 2, "--", 2) == 0)
           {          
           // discard comment, just switch phase back to none
           m_phase = NONE;
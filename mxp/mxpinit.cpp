@@ -363,16 +363,18 @@ void CMUSHclientApp::MXP_LoadEntities (void)
   {
 CString strName;
 CString strReplacement;
+int iResult;
 
   for (int j = 0; character_entities [j] [0] != 0; j += 2)
     {
     strName = character_entities [j];
     strReplacement = character_entities [j + 1];
+    iResult = (unsigned char) strReplacement [0];
     if (strReplacement.Left (2) == "&#" &&
         strReplacement.Right (1) == ";")
       {
       const char * p = strReplacement;
-      int iResult = 0;
+      iResult = 0;
 
       for (p +=2; *p != ';'; p++)
         {
@@ -387,6 +389,7 @@ CString strReplacement;
       } // end of converting #&xxx;
 
     m_EntityMap.SetAt (strName, strReplacement);
+    m_EntityTable.SetAt (strName, strReplacement, iResult);   // all are one character
 
 // temporary, for displaying entities
 
@@ -416,6 +419,9 @@ CString strReplacement;
 
     }
 
+  // they never change, so make sure each lookup is a single probe
+  m_EntityTable.MakePerfect ();
+
   } // end of CMUSHclientApp::LoadEntities 
 
 
@@ -438,12 +438,15 @@ CAction * CMUSHclientDoc::GetAction (const CString & strAction,
 
 unsigned long iHash = MakeActionHash (strAction, strHint, strVariable);
 
-  for (POSITION pos = m_ActionList.GetHeadPosition (); pos; )
+  // only look at the actions with the same hash
+  pair<CActionHashMap::iterator, CActionHashMap::iterator> range = 
+                      m_ActionHashMap.equal_range (iHash);
+
+  for (CActionHashMap::iterator it = range.first; it != range.second; it++)
     {
-    CAction * pAction = m_ActionList.GetNext (pos);
+    CAction * pAction = it->second;
 
-    if (pAction->m_iHash == iHash &&
-        pAction->m_strAction == strAction &&
+    if (pAction->m_strAction == strAction &&
         pAction->m_strHint == strHint &&
         pAction->m_strVariable == strVariable)
       {
@@ -458,7 +461,8 @@ unsigned long iHash = MakeActionHash (strAction, strHint, strVariable);
   CAction * pAction = new CAction (strAction, strHint, strVariable, this);
 
   pAction->AddRef ();
-  m_ActionList.AddTail (pAction);   
+  pAction->m_pos = m_ActionList.AddTail (pAction);   
+  m_ActionHashMap.insert (CActionHashMap::value_type (iHash, pAction));
   
   return pAction;
   } // end of CMUSHclientDoc::GetAction
@@ -475,6 +479,7 @@ CAction::CAction (const CString & strAction,
   m_strHint = strHint;
   m_strVariable = strVariable;
   m_pDoc = pDoc;
+  m_pos = NULL;
 
   m_iHash = MakeActionHash (strAction, strHint, strVariable);
 
@@ -497,10 +502,21 @@ void CAction::Release (void)
   m_iRefCount--; 
   if (m_iRefCount <= 0)
     {
-    POSITION pos = m_pDoc->m_ActionList.Find (this);
-    ASSERT (pos);
-    if (pos)
-       m_pDoc->m_ActionList.RemoveAt (pos);
+    ASSERT (m_pos);
+    if (m_pos)
+       m_pDoc->m_ActionList.RemoveAt (m_pos);
+
+    // and from the lookup table
+    pair<CActionHashMap::iterator, CActionHashMap::iterator> range = 
+                        m_pDoc->m_ActionHashMap.equal_range (m_iHash);
+
+    for (CActionHashMap::iterator it = range.first; it != range.second; it++)
+      if (it->second == this)
+        {
+        m_pDoc->m_ActionHashMap.erase (it);
+        break;
+        }
+
     delete this;
     } // this one not wanted any more
   }; // end of CAction::Release
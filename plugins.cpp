@@ -176,6 +176,11 @@ CPlugin::CPlugin (CMUSHclientDoc * pDoc)
 // destructor
 CPlugin::~CPlugin () 
   {
+  // we have already been taken out of m_PluginList - make sure anything OnPluginClose
+  // sends or broadcasts doesn't find us in the cached subscribers, or pass the
+  // generation check in a callback loop which is already under way
+  m_pDoc->PluginSubscribersChanged ();
+
   // change to this plugin, call function, put current plugin back
   CPlugin * pSavedPlugin = m_pDoc->m_CurrentPlugin;
   m_pDoc->m_CurrentPlugin = this;
@@ -200,6 +205,9 @@ CPlugin::~CPlugin ()
          delete m;
          }
 
+  // don't call us any more (in case OnPluginClose rebuilt the subscribers)
+  m_pDoc->PluginSubscribersChanged ();
+
   } // end of destructor
 
 DISPID CPlugin::GetPluginDispid (const char * sName)
@@ -1371,6 +1379,7 @@ void CMUSHclientDoc::OnFilePluginwizard()
           delete v;
           // now delete its entry
           m_VariableMap.RemoveKey (strName);
+          NoteVariableChanged (strName);
           }   // end of selected Variable
     
         // show document modified
@@ -1409,20 +1418,82 @@ static bool bInPluginListChanged = false;
   }    // end CMUSHclientDoc::PluginListChanged 
 
 
+// Most plugins only implement a few callbacks, so rather than asking every plugin
+// whether it has (say) OnPluginPacketReceived, every time a packet arrives, we
+// keep a list, for each callback, of the enabled plugins which have it.
+
+const CPluginVector & CMUSHclientDoc::GetPluginSubscribers (const string & sName)
+  {
+  static const CPluginVector vNoSubscribers;
+
+  if (!m_bPluginSubscribersValid)
+    {
+    m_PluginSubscribers.clear ();
+
+    for (PluginListIterator pit = m_PluginList.begin (); 
+         pit != m_PluginList.end (); 
+         ++pit)
+      {
+      CPlugin * pPlugin = *pit;
+
+      if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+        continue;
+
+      for (CScriptDispatchIDIterator it = pPlugin->m_PluginCallbacks.begin ();
+           it != pPlugin->m_PluginCallbacks.end ();
+           it++)
+        if (it->second.isvalid ())
+          m_PluginSubscribers [it->first].push_back (pPlugin);
+      }   // end of doing each plugin
+
+    m_bPluginSubscribersValid = true;
+    } // end of rebuilding the list
+
+  CPluginSubscribersMap::const_iterator it = m_PluginSubscribers.find (sName);
+
+  if (it == m_PluginSubscribers.end ())
+    return vNoSubscribers;
+
+  return it->second;
+  } // end of CMUSHclientDoc::GetPluginSubscribers
+
+void CMUSHclientDoc::PluginSubscribersChanged (void)
+  {
+  m_bPluginSubscribersValid = false;
+  m_iPluginSubscribersGeneration++;
+  } // end of CMUSHclientDoc::PluginSubscribersChanged
+
+// the callers below work on a copy of the subscribers, as a callback might load,
+// unload, enable or disable a plugin - if so we check each one is still there
+
+bool CMUSHclientDoc::IsPluginStillSubscribed (CPlugin * pPlugin, const long iGeneration)
+  {
+  if (iGeneration == m_iPluginSubscribersGeneration)
+    return true;    // nothing has changed
+
+  PluginListIterator pit = find (m_PluginList.begin (), 
+                                 m_PluginList.end (), 
+                                 pPlugin);
+
+  return pit != m_PluginList.end () && pPlugin->m_bEnabled;
+  } // end of CMUSHclientDoc::IsPluginStillSubscribed
+
 void CMUSHclientDoc::SendToAllPluginCallbacks (const string & sName)   // no arguments
   {
   CPlugin * pSavedPlugin = m_CurrentPlugin;
+  CPluginVector vSubscribers = GetPluginSubscribers (sName);
+  const long iGeneration = m_iPluginSubscribersGeneration;
 
   m_bNotesNotWantedNow = true;  // batch up Note/Tell calls
 
   // tell a plugin the message
-   for (PluginListIterator pit = m_PluginList.begin (); 
-         pit != m_PluginList.end (); 
+   for (CPluginVector::const_iterator pit = vSubscribers.begin (); 
+         pit != vSubscribers.end (); 
          ++pit)
     {
     CPlugin * pPlugin = *pit;
 
-    if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+    if (!IsPluginStillSubscribed (pPlugin, iGeneration))
       continue;
 
     // change to this plugin, call function, put current plugin back
@@ -1441,17 +1512,19 @@ void CMUSHclientDoc::SendToAllPluginCallbacks (const string & sName)   // no arg
 bool CMUSHclientDoc::SendToFirstPluginCallbacks (const string & sName, const char * sText)   // one argument
   {
   CPlugin * pSavedPlugin = m_CurrentPlugin;
+  CPluginVector vSubscribers = GetPluginSubscribers (sName);
+  const long iGeneration = m_iPluginSubscribersGeneration;
 
   m_bNotesNotWantedNow = true;  // batch up Note/Tell calls
 
   // tell a plugin the message
-   for (PluginListIterator pit = m_PluginList.begin (); 
-         pit != m_PluginList.end (); 
+   for (CPluginVector::const_iterator pit = vSubscribers.begin (); 
+         pit != vSubscribers.end (); 
          ++pit)
     {
     CPlugin * pPlugin = *pit;
 
-    if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+    if (!IsPluginStillSubscribed (pPlugin, iGeneration))
       continue;
 
     // change to this plugin, call function, put current plugin back
@@ -1481,17 +1554,19 @@ bool CMUSHclientDoc::SendToAllPluginCallbacks (const string & sName,
                                                const bool bStopOnFalse)
   {
   CPlugin * pSavedPlugin = m_CurrentPlugin;
+  CPluginVector vSubscribers = GetPluginSubscribers (sName);
+  const long iGeneration = m_iPluginSubscribersGeneration;
   bool bResult = true;    // assume they OK'd something
   m_bNotesNotWantedNow = true;  // batch up Note/Tell calls
 
   // tell a plugin the message
-  for (PluginListIterator pit = m_PluginList.begin (); 
-         pit != m_PluginList.end (); 
+  for (CPluginVector::const_iterator pit = vSubscribers.begin (); 
+         pit != vSubscribers.end (); 
          ++pit)
     {
     CPlugin * pPlugin = *pit;
 
-    if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+    if (!IsPluginStillSubscribed (pPlugin, iGeneration))
       continue;
 
     // change to this plugin, call function, put current plugin back
@@ -1518,16 +1593,18 @@ bool CMUSHclientDoc::SendToAllPluginCallbacks (const string & sName,
 void CMUSHclientDoc::SendToAllPluginCallbacksRtn (const string & sName, CString & strResult)  // taking and returning a string
   {
   CPlugin * pSavedPlugin = m_CurrentPlugin;
+  CPluginVector vSubscribers = GetPluginSubscribers (sName);
+  const long iGeneration = m_iPluginSubscribersGeneration;
   m_bNotesNotWantedNow = true;  // batch up Note/Tell calls
 
   // tell a plugin the message
-  for (PluginListIterator pit = m_PluginList.begin (); 
-         pit != m_PluginList.end (); 
+  for (CPluginVector::const_iterator pit = vSubscribers.begin (); 
+         pit != vSubscribers.end (); 
          ++pit)
     {
     CPlugin * pPlugin = *pit;
 
-    if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+    if (!IsPluginStillSubscribed (pPlugin, iGeneration))
       continue;
 
     // change to this plugin, call function, put current plugin back
@@ -1550,16 +1627,18 @@ bool CMUSHclientDoc::SendToAllPluginCallbacks (const string & sName,
                                                const bool bStopOnFalse)
   {
   CPlugin * pSavedPlugin = m_CurrentPlugin;
+  CPluginVector vSubscribers = GetPluginSubscribers (sName);
+  const long iGeneration = m_iPluginSubscribersGeneration;
   m_bNotesNotWantedNow = true;  // batch up Note/Tell calls
 
   // tell a plugin the message
-  for (PluginListIterator pit = m_PluginList.begin (); 
-         pit != m_PluginList.end (); 
+  for (CPluginVector::const_iterator pit = vSubscribers.begin (); 
+         pit != vSubscribers.end (); 
          ++pit)
     {
     CPlugin * pPlugin = *pit;
 
-    if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+    if (!IsPluginStillSubscribed (pPlugin, iGeneration))
       continue;
 
     // change to this plugin, call function, put current plugin back
@@ -1600,16 +1679,18 @@ bool CMUSHclientDoc::SendToAllPluginCallbacks (const string & sName,
                                                const bool bStopOnFalse)
   {
   CPlugin * pSavedPlugin = m_CurrentPlugin;
+  CPluginVector vSubscribers = GetPluginSubscribers (sName);
+  const long iGeneration = m_iPluginSubscribersGeneration;
   m_bNotesNotWantedNow = true;  // batch up Note/Tell calls
 
   // tell a plugin the message
-  for (PluginListIterator pit = m_PluginList.begin (); 
-         pit != m_PluginList.end (); 
+  for (CPluginVector::const_iterator pit = vSubscribers.begin (); 
+         pit != vSubscribers.end (); 
          ++pit)
     {
     CPlugin * pPlugin = *pit;
 
-    if (!(pPlugin->m_bEnabled))   // ignore disabled plugins
+    if (!IsPluginStillSubscribed (pPlugin, iGeneration))
       continue;
 
     // change to this plugin, call function, put current plugin back
@@ -94,10 +94,13 @@ class CPlugin :public CObject
   CAliasRevMap  m_AliasRevMap;   // for getting name back from pointer
   CTriggerMap   m_TriggerMap;   // triggers    
   CTriggerArray m_TriggerArray; // array of triggers for sequencing
+  CTriggerPrefilter m_TriggerPrefilter; // literal text prefilter for m_TriggerArray
   CTriggerRevMap m_TriggerRevMap; // for getting name back from pointer
   CTimerMap     m_TimerMap;     // timers      
   CTimerRevMap  m_TimerRevMap;   // for getting name back from pointer
+  CTimerQueue   m_TimerQueue;    // which timers are due next
   CVariableMap  m_VariableMap;  // variables   
+  CVariableDependencyMap m_VariableDependencies;  // which triggers use which variables
   tStringMapOfMaps m_Arrays;    // map of arrays (for scripting)
 
   bool m_bEnabled;              // true if active (enabled)
@@ -146,6 +149,11 @@ class CPlugin :public CObject
 typedef list<CPlugin*> CPluginList;
 typedef CPluginList::iterator PluginListIterator;
 
+// for each plugin callback name, the enabled plugins which have that callback,
+// in plugin list order (see CMUSHclientDoc::GetPluginSubscribers)
+typedef vector<CPlugin*> CPluginVector;
+typedef map<string, CPluginVector> CPluginSubscribersMap;
+
 // Unary predicate for use in find_if to find a plugin by name
 //  ... not case-sensitive
 struct compare_plugin_name : binary_function <CPlugin *, CString, bool>
@@ -11,8 +11,184 @@
 static char BASED_CODE THIS_FILE[] = __FILE__;
 #endif
 
+unsigned long t_regexp::nNextSerial = 1;  // zero means "no expression"
 
-t_regexp * regcomp(const char *exp, const int options)
+// if the pattern is just text (eg. a non-regexp trigger, converted to "^text$")
+// set up re to match it without PCRE, and return true
+
+static bool ParseLiteralPattern (const char * exp, const int options, t_regexp * re)
+  {
+string sLiteral;
+bool bAtStart = false;
+bool bAtEnd = false;
+const char * p = exp;
+
+  // other options change what ^, $, spaces etc. mean
+  if (options & ~(PCRE_CASELESS | PCRE_UTF8))
+    return false;
+
+  if (*p == '^')
+    {
+    bAtStart = true;
+    p++;
+    }
+
+  for ( ; *p; p++)
+    {
+    unsigned char c = *p;
+
+    if (c == '$' && p [1] == 0)
+      {
+      bAtEnd = true;
+      break;
+      }
+
+    if (c == '\\')
+      {
+      c = *++p;
+      if (c == 'n')
+        c = '\n';
+      else if (c == 'x' && isxdigit ((unsigned char) p [1]) && isxdigit ((unsigned char) p [2]))
+        {
+        char buf [3] = { p [1], p [2], 0 };
+        c = (unsigned char) strtol (buf, NULL, 16);
+        p += 2;
+        // in UTF-8 mode \xhh is a code point, not a byte
+        if (c >= 0x80)
+          return false;
+        }
+      // \d, \b etc. (or something odd) - leave it to PCRE
+      else if (c == 0 || c >= 0x80 || isalnum (c))
+        return false;
+      // otherwise an escaped punctuation character stands for itself
+      } // end of escape
+    else if (strchr ("^$.[|()?*+{", c))
+      return false;     // a regexp after all
+
+    if (options & PCRE_CASELESS)
+      {
+      // PCRE folds the case of more than we know about
+      if (c >= 0x80)
+        return false;
+      if (c >= 'A' && c <= 'Z')
+        c += 'a' - 'A';
+      }
+
+    sLiteral += (char) c;
+    } // end of for each character
+
+  // empty patterns can be left to PCRE (they match everything, unless PCRE_NOTEMPTY)
+  if (sLiteral.empty ())
+    return false;
+
+  re->m_sLiteral = sLiteral;
+  re->m_bLiteralAtStart = bAtStart;
+  re->m_bLiteralAtEnd = bAtEnd;
+  re->m_bLiteralCaseless = (options & PCRE_CASELESS) != 0;
+  return true;
+  } // end of ParseLiteralPattern
+
+// true if the literal text is at p (which must have room for it)
+
+static inline bool LiteralAt (const t_regexp * prog, const char * p)
+  {
+  if (!prog->m_bLiteralCaseless)
+    return memcmp (p, prog->m_sLiteral.c_str (), prog->m_sLiteral.size ()) == 0;
+
+  const unsigned char * pLiteral = (const unsigned char *) prog->m_sLiteral.c_str ();
+  const unsigned char * pEnd = pLiteral + prog->m_sLiteral.size ();
+
+  for ( ; pLiteral < pEnd; pLiteral++, p++)
+    {
+    unsigned char c = *p;
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    if (c != *pLiteral)
+      return false;
+    }
+
+  return true;
+  } // end of LiteralAt
+
+// match a plain-text pattern, same results as pcre_exec would give
+
+static int LiteralExec (const t_regexp * prog, 
+                        const char * string, 
+                        const int length,
+                        const int start_offset,
+                        int * offsets)
+  {
+const int iLiteralLength = prog->m_sLiteral.size ();
+int iFound = -1;
+
+  if (prog->m_bLiteralAtStart)
+    {
+    // ^ only matches at the start of the subject (we don't do multi-line)
+    if (start_offset == 0 &&
+        length >= iLiteralLength && 
+        LiteralAt (prog, string))
+      iFound = 0;
+    }
+  else if (prog->m_bLiteralAtEnd)
+    {
+    // $ matches at the end, or before a newline at the end - try leftmost first
+    int iPos = length - iLiteralLength;
+    if (length > 0 && string [length - 1] == '\n' && 
+        iPos - 1 >= start_offset && LiteralAt (prog, &string [iPos - 1]))
+      iFound = iPos - 1;
+    else if (iPos >= start_offset && LiteralAt (prog, &string [iPos]))
+      iFound = iPos;
+    }
+  else
+    {
+    // anywhere - look for the first character quickly, then compare the rest
+    const char * p = &string [start_offset];
+    const char * pLast = &string [length - iLiteralLength];   // last possible start
+    const char cFirst = prog->m_sLiteral [0];
+
+    if (!prog->m_bLiteralCaseless || !isalpha ((unsigned char) cFirst))
+      {
+      while (p <= pLast && 
+            (p = (const char *) memchr (p, cFirst, pLast - p + 1)) != NULL)
+        {
+        if (LiteralAt (prog, p))
+          {
+          iFound = p - string;
+          break;
+          }
+        p++;
+        }
+      } // end of exact first character
+    else
+      {
+      const char cUpper = cFirst + 'A' - 'a';
+      for ( ; p <= pLast; p++)
+        if ((*p == cFirst || *p == cUpper) && LiteralAt (prog, p))
+          {
+          iFound = p - string;
+          break;
+          }
+      } // end of caseless letter
+    } // end of unanchored
+
+  if (iFound < 0)
+    return PCRE_ERROR_NOMATCH;
+
+  // check the $ (if we matched at the start)
+  if (prog->m_bLiteralAtStart && prog->m_bLiteralAtEnd)
+    {
+    int iEnd = iFound + iLiteralLength;
+    if (!(iEnd == length || 
+         (iEnd == length - 1 && string [iEnd] == '\n')))
+      return PCRE_ERROR_NOMATCH;
+    }
+
+  offsets [0] = iFound;
+  offsets [1] = iFound + iLiteralLength;
+  return 1;   // just the whole match
+  } // end of LiteralExec
+
+t_regexp * regcomp(const char *exp, const int options, const bool bMatchOnly)
   {
 const char *error;
 int erroroffset;
@@ -25,8 +201,10 @@ pcre_extra * extra;
   if (!program)
     ThrowErrorException("Failed: %s at offset %d", Translate (error), erroroffset);
 
-  // study it for speed purposes
-  extra =  pcre_study(program, 0, &error);        
+  // study it for speed purposes (and JIT compile it, if this PCRE can)
+  int iHaveJIT = 0;
+  pcre_config (PCRE_CONFIG_JIT, &iHaveJIT);
+  extra =  pcre_study(program, iHaveJIT ? PCRE_STUDY_JIT_COMPILE : 0, &error);        
 
   if (error)
     {
@@ -42,10 +220,58 @@ pcre_extra * extra;
   re->m_extra = extra;
   re->m_iExecutionError = 0; // no error now
 
+  // inspired by a suggestion by Twisol (to remove a hard-coded limit on the number of wildcards)
+  // how many captures can we get?
+  pcre_fullinfo(program, NULL, PCRE_INFO_CAPTURECOUNT, &re->m_iCaptureCount);
+
+  // allocate enough memory, once, for every match we do
+  re->m_vOffsets.resize ((re->m_iCaptureCount + 1) * 3);  // we always get offset 0 - the whole match
+  re->m_vWorkOffsets.resize (re->m_vOffsets.size ());
+
+  // now choose how to execute it - we still keep the PCRE program, for named
+  // wildcards and so it can be shown to be valid
+
+  int iJITDone = 0;
+
+  if (ParseLiteralPattern (exp, options, re))
+    re->m_iBackend = eRegexpLiteral;
+  else if (extra && 
+           pcre_fullinfo (program, extra, PCRE_INFO_JIT, &iJITDone) == 0 &&
+           iJITDone)
+    re->m_iBackend = eRegexpJIT;
+  // the DFA matcher finds the longest match, not the Perl one, so only use it
+  // when nobody will look at what matched
+  else if (bMatchOnly && re->m_iCaptureCount == 0)
+    {
+    re->m_iBackend = eRegexpDFA;
+    re->m_vDFAWorkspace.resize (DFA_WORKSPACE_SIZE);
+    }
+  else
+    re->m_iBackend = eRegexpInterpreter;
+
+  // remember any literal text a match needs, for the trigger prefilter
+  re->m_sRequiredLiteral = ExtractRequiredLiteral (exp, options);
 
   return re;
   }
 
+// just checks that an expression compiles - much cheaper than regcomp, as
+// it is not studied (or JIT-compiled) and no t_regexp is made
+
+void regcheck(const char *exp, const int options)
+  {
+const char *error;
+int erroroffset;
+pcre * program;
+
+  program = pcre_compile(exp, options, &error, &erroroffset, NULL);
+
+  if (!program)
+    ThrowErrorException("Failed: %s at offset %d", Translate (error), erroroffset);
+
+  pcre_free (program);
+  }
+
 int regexec(register t_regexp *prog, 
             register const char *string,
             const int start_offset)
@@ -57,12 +283,7 @@ int count;
   if (prog->m_program == NULL)
     return false;
 
-  // inspired by a suggestion by Twisol (to remove a hard-coded limit on the number of wildcards)
-  int capturecount = 0;
-  // how many captures did we get?
-  pcre_fullinfo(prog->m_program, NULL, PCRE_INFO_CAPTURECOUNT, &capturecount);
-  // allocate enough memory
-  vector<int> offsets ((capturecount + 1) * 3);  // we always get offset 0 - the whole match
+  const int length = strlen (string);
 
   LARGE_INTEGER start, 
                 finish;
@@ -77,8 +298,39 @@ int count;
     }
 
   pcre_callout = NULL;
-  count = pcre_exec(prog->m_program, prog->m_extra, string, strlen (string),
-                    start_offset, options, &offsets [0], offsets.size ());
+
+  switch (prog->m_iBackend)
+    {
+    case eRegexpLiteral:
+      count = LiteralExec (prog, string, length, start_offset, &prog->m_vWorkOffsets [0]);
+      break;
+
+    case eRegexpDFA:
+      count = pcre_dfa_exec(prog->m_program, prog->m_extra, string, length,
+                            start_offset, options, 
+                            &prog->m_vWorkOffsets [0], prog->m_vWorkOffsets.size (),
+                            &prog->m_vDFAWorkspace [0], prog->m_vDFAWorkspace.size ());
+
+      // zero means it found more matches than we had room for - we only want one
+      if (count == 0)
+        count = 1;
+
+      // some things (eg. back references) it can't do - use the interpreter from now on
+      if (count <= PCRE_ERROR_DFA_UITEM && count >= PCRE_ERROR_DFA_RECURSE)
+        {
+        prog->m_iBackend = eRegexpInterpreter;
+        count = pcre_exec(prog->m_program, prog->m_extra, string, length,
+                          start_offset, options, 
+                          &prog->m_vWorkOffsets [0], prog->m_vWorkOffsets.size ());
+        }
+      break;
+
+    default:    // pcre_exec uses the JIT code, if there is any
+      count = pcre_exec(prog->m_program, prog->m_extra, string, length,
+                        start_offset, options, 
+                        &prog->m_vWorkOffsets [0], prog->m_vWorkOffsets.size ());
+      break;
+    } // end of switch on backend
 
   if (App.m_iCounterFrequency)
     {
@@ -96,7 +348,7 @@ int count;
     {
     pcre_free (prog->m_program);
     prog->m_program = NULL;
-    pcre_free (prog->m_extra);
+    pcre_free_study (prog->m_extra);
     prog->m_extra = NULL;
     prog->m_iExecutionError = count; // remember reason
     ThrowErrorException (TFormat ("Error executing regular expression: %s",
@@ -106,11 +358,12 @@ int count;
 
   // if, and only if, we match, we will save the matching string, the count
   // and offsets, so we can extract the wildcards later on
+  //  - assign and swap reuse the existing buffers, so nothing is allocated
+  //    once the target string has grown to the usual line length
 
-  prog->m_sTarget = string;  // for extracting wildcards
+  prog->m_sTarget.assign (string, length);  // for extracting wildcards
   prog->m_iCount = count;    // ditto
-  prog->m_vOffsets.clear (); 
-  copy (offsets.begin (), offsets.end (), back_inserter (prog->m_vOffsets));
+  prog->m_vOffsets.swap (prog->m_vWorkOffsets); 
   return true; // match
   }
 
@@ -146,4 +399,307 @@ pcre * program;
   dlg.m_iColumn = erroroffset + 1;
   dlg.DoModal ();
   return false;   // bad
-  }
\ No newline at end of file
+  }
+
+/* -------------------------------------------------------------------- *
+ *  ExtractRequiredLiteral - finds the longest run of literal text      *
+ *   which every match of the expression must contain.                  *
+ *                                                                      *
+ *  This is deliberately conservative: anything it does not understand  *
+ *  (alternation, inline options, escapes like \d, classes, groups)     *
+ *  just ends the current run of literal text. Dropping text is always  *
+ *  safe, claiming text is required when it is not would lose matches.  *
+ *                                                                      *
+ *  The result is lower-cased, so the caller must fold the subject the  *
+ *  same way before searching for it.                                   *
+ * -------------------------------------------------------------------- */
+
+// skip a quantifier (eg. *, +?, {2,3}) returning the new position - or NULL if none there
+static const char * SkipQuantifier (const char * p)
+  {
+  if (*p == '*' || *p == '+' || *p == '?')
+    p++;
+  else if (*p == '{')
+    {
+    const char * q = p + 1;
+    if (!isdigit ((unsigned char) *q))
+      return NULL;    // not a quantifier, eg. {foo}
+    while (isdigit ((unsigned char) *q))
+      q++;
+    if (*q == ',')
+      q++;
+    while (isdigit ((unsigned char) *q))
+      q++;
+    if (*q != '}')
+      return NULL;    // not a quantifier, eg. {1,x
+    p = q + 1;
+    }
+  else
+    return NULL;
+
+  // lazy or possessive suffix
+  if (*p == '?' || *p == '+')
+    p++;
+
+  return p;
+  } // end of SkipQuantifier
+
+// skip a character class - p points past the opening [
+static const char * SkipClass (const char * p)
+  {
+  if (*p == '^')
+    p++;
+  if (*p == ']')    // a leading ] is literal
+    p++;
+
+  while (*p && *p != ']')
+    {
+    if (*p == '\\' && p [1])
+      p += 2;
+    else if (*p == '[' && p [1] == ':')   // [:alpha:]
+      {
+      const char * q = strstr (p + 2, ":]");
+      p = q ? q + 2 : p + 1;
+      }
+    else
+      p++;
+    }
+
+  if (*p == ']')
+    p++;
+  return p;
+  } // end of SkipClass
+
+string ExtractRequiredLiteral (const char * exp, const int options)
+  {
+string sBest,       // longest run found so far
+       sCurrent;    // run we are building now
+const bool bCaseless = (options & PCRE_CASELESS) != 0;
+const char * p = exp;
+
+  // extended mode allows comments and ignored white space - too hard
+  if (options & PCRE_EXTENDED)
+    return "";
+
+  while (*p)
+    {
+    unsigned char c;
+    bool bLiteral = false;
+
+    switch (*p)
+      {
+      case '\\':
+        if (p [1] == 0)
+          {
+          p++;
+          break;
+          }
+
+        // \Q ... \E quoting - not worth the trouble
+        if (p [1] == 'Q')
+          return "";
+
+        if (isalnum ((unsigned char) p [1]))
+          {
+          // \d, \b, \x1B, \1, \p{L} and so on - not literal text
+          char cEscape = p [1];
+          p += 2;
+          if (*p == '{' && strchr ("xopPgk", cEscape))
+            {
+            while (*p && *p != '}')
+              p++;
+            if (*p)
+              p++;
+            }
+          else if (cEscape == 'x')
+            {
+            for (int i = 0; i < 2 && isxdigit ((unsigned char) *p); i++)
+              p++;
+            }
+          else if (cEscape == 'c')
+            {
+            if (*p)
+              p++;
+            }
+          else if (cEscape == 'p' || cEscape == 'P')
+            {
+            if (*p)
+              p++;
+            }
+          else if (cEscape == 'g' || cEscape == 'k')
+            {
+            char cClose = *p == '<' ? '>' : *p == '\'' ? '\'' : 0;
+            if (cClose)
+              {
+              p++;
+              while (*p && *p != cClose)
+                p++;
+              if (*p)
+                p++;
+              }
+            else
+              {
+              if (*p == '-' || *p == '+')
+                p++;
+              while (isdigit ((unsigned char) *p))
+                p++;
+              }
+            }
+          else if (isdigit ((unsigned char) cEscape))
+            {
+            while (isdigit ((unsigned char) *p))
+              p++;
+            }
+
+          if (sCurrent.size () > sBest.size ())
+            sBest = sCurrent;
+          sCurrent.erase ();
+          break;
+          }
+
+        // escaped punctuation, eg. \. or \(
+        c = p [1];
+        p += 2;
+        bLiteral = true;
+        break;
+
+      case '|':
+        // alternation at the outer level means nothing is definitely required
+        return "";
+
+      case '[':
+        p = SkipClass (p + 1);
+        if (sCurrent.size () > sBest.size ())
+          sBest = sCurrent;
+        sCurrent.erase ();
+        break;
+
+      case '(':
+        {
+        // an option setting like (?i) changes the meaning of what follows
+        if (p [1] == '?')
+          {
+          const char * q = p + 2;
+          while (isalpha ((unsigned char) *q) || *q == '-')
+            q++;
+          if (*q == ')')
+            return "";
+          }
+
+        // skip the whole group, it might be optional or contain alternatives
+        int iDepth = 0;
+        while (*p)
+          {
+          if (*p == '\\' && p [1])
+            {
+            p += 2;
+            continue;
+            }
+          if (*p == '[')
+            {
+            p = SkipClass (p + 1);
+            continue;
+            }
+          if (*p == '(')
+            iDepth++;
+          else if (*p == ')')
+            {
+            iDepth--;
+            if (iDepth == 0)
+              {
+              p++;
+              break;
+              }
+            }
+          p++;
+          }
+
+        if (sCurrent.size () > sBest.size ())
+          sBest = sCurrent;
+        sCurrent.erase ();
+        }
+        break;
+
+      case '{':
+        // not a valid quantifier (eg. {foo}) means a literal {
+        if (SkipQuantifier (p) == NULL)
+          {
+          c = *p++;
+          bLiteral = true;
+          break;
+          }
+
+        // a quantifier on nothing in particular - skipped below
+        if (sCurrent.size () > sBest.size ())
+          sBest = sCurrent;
+        sCurrent.erase ();
+        break;
+
+      case '.':
+      case '^':
+      case '$':
+      case ')':
+      case '*':
+      case '+':
+      case '?':
+        p++;
+        if (sCurrent.size () > sBest.size ())
+          sBest = sCurrent;
+        sCurrent.erase ();
+        break;
+
+      default:
+        c = *p++;
+        bLiteral = true;
+        break;
+
+      } // end of switch
+
+    if (!bLiteral)
+      {
+      // skip the whole of any quantifier on what we just passed (eg. \d{2,3} or .{1,20})
+      // otherwise its digits would look like literal text
+      if (const char * q = SkipQuantifier (p))
+        p = q;
+      continue;
+      }
+
+    // for a caseless match we can only safely fold ASCII (and in UTF-8 mode
+    // k and s also match the Kelvin sign and long s)
+    if (bCaseless && (c >= 0x80 || 
+                      ((options & PCRE_UTF8) && strchr ("kKsS", c))))
+      {
+      if (sCurrent.size () > sBest.size ())
+        sBest = sCurrent;
+      sCurrent.erase ();
+      if (const char * q = SkipQuantifier (p))
+        p = q;
+      continue;
+      }
+
+    const char * q = SkipQuantifier (p);
+
+    // fold ASCII only - the prefilter folds the subject the same way
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+
+    if (q == NULL)
+      sCurrent += (char) c;   // plain literal character
+    else
+      {
+      // with "+" the character is there at least once, otherwise it might not be
+      if (*p == '+' || (*p == '{' && p [1] != '0'))
+        sCurrent += (char) c;
+      if (sCurrent.size () > sBest.size ())
+        sBest = sCurrent;
+      sCurrent.erase ();
+      p = q;
+      }
+
+    } // end of while
+
+  if (sCurrent.size () > sBest.size ())
+    sBest = sCurrent;
+
+  return sBest;
+  } // end of ExtractRequiredLiteral
@@ -23,6 +23,18 @@
 // for duplicate named wildcards
 int njg_get_first_set(const pcre *code, const char *stringname, const int *ovector);
 
+// how a compiled expression is executed (chosen by regcomp)
+enum
+  {
+  eRegexpInterpreter,     // pcre_exec, the usual way
+  eRegexpJIT,             // pcre_exec, using JIT-compiled code
+  eRegexpDFA,             // pcre_dfa_exec, for match/no-match tests without captures
+  eRegexpLiteral          // plain text - PCRE not used at all
+  };
+
+// workspace (ints) for pcre_dfa_exec
+#define DFA_WORKSPACE_SIZE 1000
+
 // compiled regular expression type
 
 class t_regexp 
@@ -35,22 +47,31 @@ class t_regexp
       m_extra = NULL;
       iTimeTaken = 0;
       m_iCount = 0;
+      m_iCaptureCount = 0;
       m_iMatchAttempts = 0;
       m_iExecutionError = 0;
+      m_iBackend = eRegexpInterpreter;
+      m_bLiteralAtStart = false;
+      m_bLiteralAtEnd = false;
+      m_bLiteralCaseless = false;
+      m_iSerial = nNextSerial++;
                 };   // constructor
   ~t_regexp () { 
     if (m_program) 
       pcre_free (m_program); 
     if (m_extra) 
-      pcre_free (m_extra); 
+      pcre_free_study (m_extra); 
     };  // destructor
 
-  // pairs of offsets from match
+  // pairs of offsets from match (sized once, when compiled)
   vector<int> m_vOffsets;
   // count of matching wildcards
   int m_iCount;
+  // number of capturing groups in the expression (found when compiled)
+  int m_iCaptureCount;
   long m_iMatchAttempts;
   // the string we match on (to extract wildcards from)
+  //  - reassigned on each match, so its buffer is reused
   string m_sTarget;
   // the program itself
   pcre * m_program;	    
@@ -62,15 +83,60 @@ class t_regexp
 
   int m_iExecutionError;  // error code if failed execution
 
+  // literal text (lower-cased) which every match must contain - empty if not known
+  //  - used by the trigger prefilter to skip expressions which cannot match
+  string m_sRequiredLiteral;
+
+  // unique for each compiled expression, so a stale reference to one can be detected
+  unsigned long m_iSerial;
+
+  // how we execute it - see enum above
+  int m_iBackend;
+
+  // for eRegexpLiteral - the text (lower-cased if caseless) and where it must be
+  string m_sLiteral;
+  bool m_bLiteralAtStart;   // pattern started with ^
+  bool m_bLiteralAtEnd;     // pattern ended with $
+  bool m_bLiteralCaseless;
+
+  // for eRegexpDFA
+  vector<int> m_vDFAWorkspace;
+
+  // for GetTriggerInfo etc.
+  const char * GetBackendName (void) const
+    {
+    switch (m_iBackend)
+      {
+      case eRegexpJIT:      return "jit";
+      case eRegexpDFA:      return "dfa";
+      case eRegexpLiteral:  return "literal";
+      default:              return "interpreter";
+      } // end of switch
+    };
+
+  // finds a numbered wildcard in the matched text, without copying it
+  //  - pStart and iLength are only valid until the next successful match
+  bool GetWildcardView (const int iNumber, const char * & pStart, int & iLength) const
+    {
+    // unset groups have offsets of -1
+    if (iNumber >= 0 && iNumber < m_iCount && m_vOffsets [iNumber * 2] >= 0)
+      {
+      pStart = &m_sTarget.c_str () [m_vOffsets [iNumber * 2]];
+      iLength = m_vOffsets [(iNumber * 2) + 1] - m_vOffsets [iNumber * 2];
+      return true;
+      }
+    pStart = "";
+    iLength = 0;
+    return false;
+    };
+
   // returns a numbered wildcard
   string GetWildcard (const int iNumber) const
     {
-    if (iNumber >= 0 && iNumber < m_iCount)
-      return string (
-      &m_sTarget.c_str () [m_vOffsets [iNumber * 2]],
-      m_vOffsets [(iNumber * 2) + 1] - m_vOffsets [iNumber * 2]).c_str ();
-    else
-      return "";
+    const char * pStart;
+    int iLength;
+    GetWildcardView (iNumber, pStart, iLength);
+    return string (pStart, iLength);
     };
 
   // returns a named wildcard
@@ -89,13 +155,26 @@ class t_regexp
     return GetWildcard (iNumber);
     }
 
+  // pcre_exec works in here, and it is swapped with m_vOffsets on a match,
+  // so a failed match leaves the previous wildcards intact
+  vector<int> m_vWorkOffsets;
+
+  private:
+    static unsigned long nNextSerial;
+
   };
 
-t_regexp * regcomp(const char *exp, const int options = 0);
+t_regexp * regcomp(const char *exp, 
+                   const int options = 0,
+                   const bool bMatchOnly = false);  // true if caller never needs the match offsets
+void regcheck(const char *exp,
+              const int options = 0);   // throws, as regcomp does, if it won't compile
 int regexec(register t_regexp *prog,
             register const char *string,
             const int start_offset = 0);
 
 bool CheckRegularExpression (const CString strRegexp, const int iOptions);
 
+string ExtractRequiredLiteral (const char * exp, const int options);
+
 #endif  // #ifndef __REGEXP_H
@@ -186,12 +186,14 @@ tInternalFunctionsTable InternalFunctionsTable [] = {
 { "GetLineCount" ,               "( )" } ,
 { "GetLineInfo" ,                "( LineNumber , InfoType )" } ,
 { "GetLinesInBufferCount" ,      "( )" } ,
+{ "GetLinesMatching" ,           "( Text , MatchCase , Regexp )" } ,
 { "GetLoadedValue" ,             "( OptionName )" } ,
 { "GetMainWindowPosition" ,      "( )" } ,
 { "GetMapColour" ,               "( Which )" } ,
 { "GetMappingCount" ,            "( )" } ,
 { "GetMappingItem" ,             "( Item )" } ,
 { "GetMappingString" ,           "( )" } ,
+{ "GetMXPMessageCount" ,         "( MessageNumber )" } ,
 { "GetNotepadLength" ,           "( Title )" } ,
 { "GetNotepadList" ,             "( All )" } ,
 { "GetNotepadText" ,             "( Title )" } ,
@@ -63,25 +63,22 @@ LUALIB_API void *isudata (lua_State *L, int ud, const char *tname) {
 static CMUSHclientDoc *doc (lua_State *L) 
   { 
 // mushclient_typename is "mushclient.world"
-CMUSHclientDoc **ud = (CMUSHclientDoc **) isudata (L, 1, mushclient_typename);
+__int64 *ud = (__int64 *) isudata (L, 1, mushclient_typename);
 
   // if first argument is a world userdatum, take that as our world
 
   if (ud)
     {
-    CMUSHclientDoc * pWantedDoc = *ud;
-    luaL_argcheck(L, ud != NULL, 1, "'world' expected");
+    __int64 iWantedDoc = *ud;
     lua_remove (L, 1);    // remove the userdata, we don't need it now
 
-    // for safety, check that world still exists
-    for (POSITION docPos = App.m_pWorldDocTemplate->GetFirstDocPosition();
-        docPos != NULL; )
-      {
-      CMUSHclientDoc * pDoc = (CMUSHclientDoc *) App.m_pWorldDocTemplate->GetNextDoc(docPos);
+    // for safety, check that world still exists - the userdatum holds the
+    // world's unique document number, which is never reused, so a closed
+    // world (or a new one at the same address) cannot be mistaken for it
+    CWorldDocumentMapIterator it = App.m_WorldDocuments.find (iWantedDoc);
 
-      if (pDoc == pWantedDoc)
-        return pDoc;
-      } // end of doing each document
+    if (it != App.m_WorldDocuments.end ())
+      return it->second;
 
     luaL_error (L, "world is no longer available");
     }
@@ -177,6 +174,59 @@ int pushVariant (lua_State *L, VARIANT & v)
   return 1;  // number of result fields
   } // end of pushVariant
 
+// Methods return strings in a VARIANT as a BSTR, which means converting them to
+// Unicode and back again (and losing anything after an imbedded null).
+// While one of these exists, SetUpVariantString gives the string straight to it
+// instead, returning a VT_BSTR variant with no BSTR in it, which Push looks for.
+// WSH languages, which do not use one, get a proper BSTR as before.
+//
+// Only create it once the arguments are checked, as a Lua error would skip
+// the destructor.
+
+class CLuaStringResult
+  {
+  public:
+
+  CLuaStringResult (CMUSHclientDoc * pDoc) : m_pDoc (pDoc), 
+                                             m_pPrevious (pDoc->m_pLuaStringResult)
+    {
+    m_pDoc->m_pLuaStringResult = &m_strResult;
+    };
+
+  ~CLuaStringResult () { Release (); };
+
+  // pushes the method's result (the VARIANT it returned)
+  int Push (lua_State *L, VARIANT & v)
+    {
+    // SetUpVariantString takes the pointer when it gives us the string
+    bool bGotString = m_pDoc && m_pDoc->m_pLuaStringResult != &m_strResult;
+
+    Release ();   // before anything which might raise a Lua error
+
+    if (bGotString && v.vt == VT_BSTR && v.bstrVal == NULL)
+      {
+      lua_pushlstring (L, m_strResult, m_strResult.GetLength ());
+      return 1;  // number of result fields
+      }
+
+    return pushVariant (L, v);
+    };
+
+  private:
+
+  void Release (void)
+    {
+    if (m_pDoc)
+      m_pDoc->m_pLuaStringResult = m_pPrevious;
+    m_pDoc = NULL;
+    };
+
+  CMUSHclientDoc * m_pDoc;
+  CString * m_pPrevious;    // in case we are nested
+  CString m_strResult;
+
+  };  // end of class CLuaStringResult
+
 // helper function for pushing results returned by normal MUSHclient methods
 // (stored in a BSTR)
 
@@ -2653,11 +2703,11 @@ static int L_GetAlias (lua_State *L)
 static int L_GetAliasInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetAliasInfo (
-      my_checkstring (L, 1),    // Name
-      my_checknumber (L, 2)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sName = my_checkstring (L, 1);
+  long iType = my_checknumber (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetAliasInfo (sName, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetAliasInfo
 
 
@@ -2677,11 +2727,11 @@ static int L_GetAliasList (lua_State *L)
 static int L_GetAliasOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetAliasOption (
-      my_checkstring (L, 1),    // Name
-      my_checkstring (L, 2)     // Option name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sName = my_checkstring (L, 1);
+  const char * sOptionName = my_checkstring (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetAliasOption (sName, sOptionName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetAliasOption
 
 
@@ -2705,10 +2755,10 @@ static int L_GetAliasWildcard (lua_State *L)
 static int L_GetAlphaOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetAlphaOption (
-      my_checkstring (L, 1) // Name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sName = my_checkstring (L, 1);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetAlphaOption (sName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetAlphaOption
 
 
@@ -2810,10 +2860,10 @@ static int L_GetConnectDuration (lua_State *L)
 static int L_GetCurrentValue (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetCurrentValue (
-            my_checkstring (L, 1)   // OptionName
-            );
-  return pushVariant (L, v);
+  const char * sOptionName = my_checkstring (L, 1);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetCurrentValue (sOptionName);
+  return result.Push (L, v);
   } // end of L_GetCurrentValue
 
 
@@ -2836,10 +2886,10 @@ static int L_GetCustomColourName (lua_State *L)
 static int L_GetDefaultValue (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetDefaultValue (
-            my_checkstring (L, 1)   // OptionName
-            );
-  return pushVariant (L, v);
+  const char * sOptionName = my_checkstring (L, 1);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetDefaultValue (sOptionName);
+  return result.Push (L, v);
   } // end of L_GetDefaultValue
 
 //----------------------------------------
@@ -2930,10 +2980,10 @@ static int L_GetHostName (lua_State *L)
 static int L_GetInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetInfo (
-            my_checknumber (L, 1)   // InfoType
-            );
-  return pushVariant (L, v);
+  long iInfoType = my_checknumber (L, 1);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetInfo (iInfoType);
+  return result.Push (L, v);
   } // end of L_GetInfo
 
 
@@ -3017,8 +3067,9 @@ static int L_GetLineInfo (lua_State *L)
     }     // end of returning a table
 
   // normal behaviour
+  CLuaStringResult result (pDoc);
   VARIANT v = pDoc->GetLineInfo (iLine, iType);
-  return pushVariant (L, v);
+  return result.Push (L, v);
   } // end of L_GetLineInfo
 
 
@@ -3033,15 +3084,30 @@ static int L_GetLinesInBufferCount (lua_State *L)
 
 
 //----------------------------------------
-//  world.GetLoadedValue
+//  world.GetLinesMatching
 //----------------------------------------
-static int L_GetLoadedValue (lua_State *L)
+static int L_GetLinesMatching (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetLoadedValue (
-            my_checkstring (L, 1)   // OptionName
+  VARIANT v = pDoc->GetLinesMatching (
+            my_checkstring (L, 1),    // Text
+            optboolean (L, 2, 0),     // MatchCase
+            optboolean (L, 3, 0)      // Regexp
             );
   return pushVariant (L, v);
+  } // end of L_GetLinesMatching
+
+
+//----------------------------------------
+//  world.GetLoadedValue
+//----------------------------------------
+static int L_GetLoadedValue (lua_State *L)
+  {
+  CMUSHclientDoc *pDoc = doc (L);
+  const char * sOptionName = my_checkstring (L, 1);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetLoadedValue (sOptionName);
+  return result.Push (L, v);
   } // end of L_GetLoadedValue
 
 static void luaWindowPositionHelper (lua_State *L, const RECT & r)
@@ -3216,6 +3282,15 @@ static int L_GetMappingString (lua_State *L)
   return pushVariant (L, v);
   } // end of L_GetMappingString
 
+//----------------------------------------
+//  world.GetMXPMessageCount
+//----------------------------------------
+static int L_GetMXPMessageCount (lua_State *L)
+  {
+  lua_pushnumber (L, doc (L)->GetMXPMessageCount (my_checknumber (L, 1)));
+  return 1;  // number of result fields
+  } // end of L_GetMXPMessageCount
+
 //----------------------------------------
 //  world.Menu
 //----------------------------------------
@@ -3318,12 +3393,12 @@ static int L_PickColour (lua_State *L)
 static int L_GetPluginAliasInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginAliasInfo (
-      my_checkstring (L, 1),    // PluginID
-      my_checkstring (L, 2),    // Name
-      my_checknumber (L, 3)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sName = my_checkstring (L, 2);
+  long iType = my_checknumber (L, 3);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginAliasInfo (sPluginID, sName, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginAliasInfo
 
 
@@ -3346,12 +3421,12 @@ static int L_GetPluginAliasList (lua_State *L)
 static int L_GetPluginAliasOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginAliasOption (
-      my_checkstring (L, 1),    // PluginID
-      my_checkstring (L, 2),    // Alias Name
-      my_checkstring (L, 3)     // Option Name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sAliasName = my_checkstring (L, 2);
+  const char * sOptionName = my_checkstring (L, 3);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginAliasOption (sPluginID, sAliasName, sOptionName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginAliasOption
 
 
@@ -3372,11 +3447,11 @@ static int L_GetPluginID (lua_State *L)
 static int L_GetPluginInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginInfo (
-      my_checkstring (L, 1),    // PluginID
-      my_checknumber (L, 2)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  long iType = my_checknumber (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginInfo (sPluginID, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginInfo
 
 
@@ -3406,12 +3481,12 @@ static int L_GetPluginName (lua_State *L)
 static int L_GetPluginTimerInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginTimerInfo (
-      my_checkstring (L, 1),    // PluginID
-      my_checkstring (L, 2),    // Name
-      my_checknumber (L, 3)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sName = my_checkstring (L, 2);
+  long iType = my_checknumber (L, 3);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginTimerInfo (sPluginID, sName, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginTimerInfo
 
 
@@ -3434,12 +3509,12 @@ static int L_GetPluginTimerList (lua_State *L)
 static int L_GetPluginTimerOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginTimerOption (
-      my_checkstring (L, 1),    // PluginID
-      my_checkstring (L, 2),    // Timer Name
-      my_checkstring (L, 3)     // Option Name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sTimerName = my_checkstring (L, 2);
+  const char * sOptionName = my_checkstring (L, 3);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginTimerOption (sPluginID, sTimerName, sOptionName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginTimerOption
 
 
@@ -3449,12 +3524,12 @@ static int L_GetPluginTimerOption (lua_State *L)
 static int L_GetPluginTriggerInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginTriggerInfo (
-      my_checkstring (L, 1),    // PluginID
-      my_checkstring (L, 2),    // Name
-      my_checknumber (L, 3)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sName = my_checkstring (L, 2);
+  long iType = my_checknumber (L, 3);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginTriggerInfo (sPluginID, sName, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginTriggerInfo
 
 
@@ -3477,12 +3552,12 @@ static int L_GetPluginTriggerList (lua_State *L)
 static int L_GetPluginTriggerOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginTriggerOption (
-      my_checkstring (L, 1),    // PluginID
-      my_checkstring (L, 2),    // Trigger Name
-      my_checkstring (L, 3)     // Option Name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sTriggerName = my_checkstring (L, 2);
+  const char * sOptionName = my_checkstring (L, 3);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginTriggerOption (sPluginID, sTriggerName, sOptionName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginTriggerOption
 
 
@@ -3492,11 +3567,11 @@ static int L_GetPluginTriggerOption (lua_State *L)
 static int L_GetPluginVariable (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetPluginVariable (
-      my_checkstring (L, 1),   // PluginID
-      my_checkstring (L, 2)    // VariableName
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sPluginID = my_checkstring (L, 1);
+  const char * sVariableName = my_checkstring (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetPluginVariable (sPluginID, sVariableName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetPluginVariable
 
 
@@ -3756,8 +3831,9 @@ static int L_GetStyleInfo (lua_State *L)
         DoStyle (L, pDoc, pLine, iStyleNumber, strText);
       else
         {   // a single type, use our usual routine to get it
+        CLuaStringResult result (pDoc);
         VARIANT v = pDoc->GetStyleInfo (iLine, iStyleNumber, iType); 
-        pushVariant (L, v);
+        result.Push (L, v);
         }
 
       lua_rawseti(L, -2, iStyleNumber);  // put individual style table into line table
@@ -3774,8 +3850,9 @@ static int L_GetStyleInfo (lua_State *L)
     }
 
   // here for usual behaviour
+  CLuaStringResult result (pDoc);
   VARIANT v = pDoc->GetStyleInfo (iLine, iStyleNumber, iType); 
-  return pushVariant (L, v);
+  return result.Push (L, v);
   } // end of L_GetStyleInfo
 
 //----------------------------------------
@@ -3838,11 +3915,11 @@ static int L_GetTimer (lua_State *L)
 static int L_GetTimerInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetTimerInfo (
-      my_checkstring (L, 1),    // TimerName
-      my_checknumber (L, 2)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sTimerName = my_checkstring (L, 1);
+  long iType = my_checknumber (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetTimerInfo (sTimerName, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetTimerInfo
 
 
@@ -3862,11 +3939,11 @@ static int L_GetTimerList (lua_State *L)
 static int L_GetTimerOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetTimerOption (
-      my_checkstring (L, 1),    // TimerName
-      my_checkstring (L, 2)     // Option name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sTimerName = my_checkstring (L, 1);
+  const char * sOptionName = my_checkstring (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetTimerOption (sTimerName, sOptionName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetTimerOption
 
 
@@ -3913,11 +3990,11 @@ static int L_GetTrigger (lua_State *L)
 static int L_GetTriggerInfo (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetTriggerInfo (
-      my_checkstring (L, 1),    // TriggerName
-      my_checknumber (L, 2)     // Type
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sTriggerName = my_checkstring (L, 1);
+  long iType = my_checknumber (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetTriggerInfo (sTriggerName, iType);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetTriggerInfo
 
 
@@ -3937,11 +4014,11 @@ static int L_GetTriggerList (lua_State *L)
 static int L_GetTriggerOption (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetTriggerOption (
-      my_checkstring (L, 1),    // TriggerName
-      my_checkstring (L, 2)     // Option name
-    );
-  return pushVariant (L, v);  // number of result fields
+  const char * sTriggerName = my_checkstring (L, 1);
+  const char * sOptionName = my_checkstring (L, 2);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetTriggerOption (sTriggerName, sOptionName);
+  return result.Push (L, v);  // number of result fields
   } // end of L_GetTriggerOption
 
 
@@ -3999,10 +4076,10 @@ static int L_GetUniqueNumber (lua_State *L)
 static int L_GetVariable (lua_State *L)
   {
   CMUSHclientDoc *pDoc = doc (L);
-  VARIANT v = pDoc->GetVariable (
-      my_checkstring (L, 1)    // VariableName
-    );
-  return pushVariant (L, v);  // number of result fields 
+  const char * sVariableName = my_checkstring (L, 1);
+  CLuaStringResult result (pDoc);  // after checking arguments
+  VARIANT v = pDoc->GetVariable (sVariableName);
+  return result.Push (L, v);  // number of result fields 
   } // end of L_GetVariable
 
 
@@ -4017,6 +4094,18 @@ static int L_GetVariableList (lua_State *L)
   } // end of L_GetVariableList
 
 
+// make a userdatum representing another world (for GetWorld, GetWorldById)
+
+static void pushWorld (lua_State *L, CMUSHclientDoc * pDoc)
+  {
+  // our "world" is a userdatum holding the world's unique document number,
+  // which doc() looks up when a method is called on it
+  __int64 *ud = (__int64 *)lua_newuserdata(L, sizeof (__int64));
+  luaL_getmetatable(L, mushclient_typename);
+  lua_setmetatable(L, -2);
+  *ud = pDoc->m_iUniqueDocumentNumber;    // store number of this world in the userdata
+  } // end of pushWorld
+
 //----------------------------------------
 //  world.GetWorld
 //----------------------------------------
@@ -4031,11 +4120,7 @@ static int L_GetWorld (lua_State *L)
   
     if (pDoc->m_mush_name.CompareNoCase (strName) == 0)
       {
-      // our "world" is a userdatum which is a pointer (to a pointer) to the world
-      CMUSHclientDoc **ud = (CMUSHclientDoc **)lua_newuserdata(L, sizeof (CMUSHclientDoc *));
-      luaL_getmetatable(L, mushclient_typename);
-      lua_setmetatable(L, -2);
-      *ud = pDoc;    // store pointer to this world in the userdata
+      pushWorld (L, pDoc);
       return 1;
 
       } // end of world found
@@ -4059,11 +4144,7 @@ static int L_GetWorldById (lua_State *L)
   
     if (pDoc->m_strWorldID.CompareNoCase (WorldID) == 0)
       {
-      // our "world" is a userdatum which is a pointer (to a pointer) to the world
-      CMUSHclientDoc **ud = (CMUSHclientDoc **)lua_newuserdata(L, sizeof (CMUSHclientDoc *));
-      luaL_getmetatable(L, mushclient_typename);
-      lua_setmetatable(L, -2);
-      *ud = pDoc;    // store pointer to this world in the userdata
+      pushWorld (L, pDoc);
       return 1;
 
       } // end of world found
@@ -6857,6 +6938,7 @@ static const struct luaL_Reg worldlib [] =
   {"GetLineCount", L_GetLineCount},
   {"GetLineInfo", L_GetLineInfo},
   {"GetLinesInBufferCount", L_GetLinesInBufferCount},
+  {"GetLinesMatching", L_GetLinesMatching},
   {"GetLoadedValue", L_GetLoadedValue},
   {"GetMainWindowPosition", L_GetMainWindowPosition},
   {"GetWorldWindowPosition", L_GetWorldWindowPosition},
@@ -6865,6 +6947,7 @@ static const struct luaL_Reg worldlib [] =
   {"GetMappingCount", L_GetMappingCount},
   {"GetMappingItem", L_GetMappingItem},
   {"GetMappingString", L_GetMappingString},
+  {"GetMXPMessageCount", L_GetMXPMessageCount},
   {"GetNotepadLength", L_GetNotepadLength},
   {"GetNotepadList", L_GetNotepadList},
   {"GetNotepadText", L_GetNotepadText},
@@ -256,6 +256,7 @@ void CScriptEngine::CloseLua ()
     lua_close (L);
     L = NULL;
     }
+  m_LuaCallbacks.clear ();    // references went with the state
   }  // end of CScriptEngine::CloseLua
 
 // send some code to Lua to be parsed
@@ -310,19 +311,125 @@ bool CScriptEngine::ParseLua (const CString & strCode, const CString & strWhat)
 
   }
 
-// For Lua we will simply use the DISPID as a flag to indicate if we found
-// the function or not, to speed up subsequent calls (calls to non-existent 
-// functions). Also, if the function later has an error we set the DISPID
-// to DISPID_UNKNOWN as a flag to not call it continuously.
+// For Lua the DISPID is a reference (luaL_ref) into the CALLBACKS_STATE table
+// in the registry, or DISPID_UNKNOWN if we didn't find the function, to speed
+// up subsequent calls (calls to non-existent functions). Also, if the function
+// later has an error we set the DISPID to DISPID_UNKNOWN as a flag to not call
+// it continuously.
+
+// Each reference is to a table of the name, already split up, eg. for
+// "handlers.combat.onHit":  { "handlers", "combat", "onHit", name = "handlers.combat.onHit" }
+// So calling it does not need to parse the name every time. We still look it 
+// up each call, so reassigning the function (eg. in a plugin) works as before.
 
 // Version 3.75+ supports dotted functions (eg. string.gsub)
 
 DISPID CScriptEngine::GetLuaDispid (const CString & strName)
   {
-  return (L && FindLuaFunction (L, strName))
-          ? 1 : DISPID_UNKNOWN;  // if known 1 is flag, otherwise DISPID_UNKNOWN
-       
-  }
+  if (!(L && FindLuaFunction (L, strName)))
+    return DISPID_UNKNOWN;
+
+  // already have a reference for this name?
+  map<string, DISPID>::const_iterator it = m_LuaCallbacks.find ((LPCTSTR) strName);
+  if (it != m_LuaCallbacks.end ())
+    return it->second;
+
+  // get (or make) the table of references
+  lua_getfield (L, LUA_REGISTRYINDEX, CALLBACKS_STATE);
+  if (!lua_istable (L, -1))
+    {
+    lua_pop (L, 1);
+    lua_newtable (L);
+    lua_pushvalue (L, -1);
+    lua_setfield (L, LUA_REGISTRYINDEX, CALLBACKS_STATE);
+    }
+
+  // the name, split at the dots
+  vector<string> v;
+  StringToVector ((LPCTSTR) strName, v, ".", true);
+
+  lua_newtable (L);
+  int i = 1;
+  for (vector<string>::const_iterator iter = v.begin ();
+       iter != v.end ();
+       iter++, i++)
+    {
+    lua_pushlstring (L, iter->c_str (), iter->size ());
+    lua_rawseti (L, -2, i);
+    }
+
+  // so we can check the reference is for the right function
+  lua_pushstring (L, strName);
+  lua_setfield (L, -2, "name");
+
+  DISPID dispid = luaL_ref (L, -2);   // pops the name table
+  lua_pop (L, 1);   // pop the table of references
+
+  m_LuaCallbacks [(LPCTSTR) strName] = dispid;
+
+  return dispid;
+  } // end of CScriptEngine::GetLuaDispid
+
+// push the function for szProcedure onto the stack, using the reference in dispid
+// (see GetLuaDispid) - falls back to GetNestedFunction if the reference is not
+// for this name (eg. a DISPID from an earlier script state)
+
+bool CScriptEngine::PushLuaFunction (const DISPID dispid, LPCTSTR szProcedure)
+  {
+  int base = lua_gettop (L);
+
+  lua_getfield (L, LUA_REGISTRYINDEX, CALLBACKS_STATE);
+  if (lua_istable (L, -1))
+    {
+    lua_rawgeti (L, -1, (int) dispid);    // get name table
+    lua_remove (L, -2);             // remove table of references
+
+    if (lua_istable (L, -1))
+      {
+      int names = lua_gettop (L);
+
+      lua_getfield (L, names, "name");
+      bool bSameName = lua_isstring (L, -1) && 
+                       strcmp (lua_tostring (L, -1), szProcedure) == 0;
+      lua_pop (L, 1);
+
+      if (bSameName)
+        {
+        bool bFound = true;
+#ifdef LUA_52
+        lua_pushglobaltable(L);
+#else
+        lua_pushvalue(L, LUA_GLOBALSINDEX);
+#endif
+        for (int i = 1; ; i++)
+          {
+          lua_rawgeti (L, names, i);  // next part of the name
+          if (lua_isnil (L, -1))
+            break;                    // no more parts
+          if (!lua_istable (L, -2))   // exit loop if not table (eg. nil)
+            {
+            bFound = false;
+            break;
+            }
+          lua_gettable (L, -2);       // get from previous table
+          lua_remove (L, -2);         // remove previous table
+          }
+        lua_pop (L, 1);   // the nil, or the part we could not look up
+
+        if (bFound && lua_isfunction (L, -1))
+          {
+          lua_remove (L, names);    // leave just the function
+          return true;              // found it
+          }
+        } // end of name matches
+      }   // end of have name table
+    }   // end of have table of references
+
+  // do it the slow way (and report the error)
+  lua_settop (L, base);
+  return GetNestedFunction (L, szProcedure, true);
+
+  } // end of CScriptEngine::PushLuaFunction
 
 
 void LuaError (lua_State *L, 
@@ -497,7 +604,7 @@ bool CScriptEngine::ExecuteLua (DISPID & dispid,  // dispatch ID, will be set to
   unsigned short iOldStyle = m_pDoc->m_iNoteStyle;
   m_pDoc->m_iNoteStyle = NORMAL;    // back to default style
 
-  if (!GetNestedFunction (L, szProcedure, true))
+  if (!PushLuaFunction (dispid, szProcedure))
     {
     dispid = DISPID_UNKNOWN;   // stop further invocations
     return true;    // error return
@@ -533,7 +640,7 @@ bool CScriptEngine::ExecuteLua (DISPID & dispid,  // dispatch ID, will be set to
     unsigned char *tabptr;
     lua_newtable(L);                                                            
     paramCount++;   // we have one more parameter to the call
-    pcre_fullinfo(regexp->m_program, regexp->m_extra, PCRE_INFO_CAPTURECOUNT, &ncapt);
+    ncapt = regexp->m_iCaptureCount;   // found when compiled
 
     for (i = 0; i <= ncapt; i++) 
       {
@@ -713,7 +820,7 @@ bool CScriptEngine::ExecuteLua (DISPID & dispid,          // dispatch ID, will b
   unsigned short iOldStyle = m_pDoc->m_iNoteStyle;
   m_pDoc->m_iNoteStyle = NORMAL;    // back to default style
 
-  if (!GetNestedFunction (L, szProcedure, true))
+  if (!PushLuaFunction (dispid, szProcedure))
     {
     dispid = DISPID_UNKNOWN;   // stop further invocations
     return true;    // error return
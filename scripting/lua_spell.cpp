@@ -0,0 +1,113 @@
+// Spell checker dictionary
+
+// Implements:
+
+//    spell.add
+//    spell.check
+//    spell.load
+//    spell.suggest
+
+// These are only registered in the spellchecker's own Lua state, and work on
+// App.m_SpellDictionary (see SpellDictionary.h).
+
+
+#include "stdafx.h"
+#include "..\MUSHclient.h"
+
+
+//----------------------- begin Lua stuff ----------------------------
+
+// spell.load (files, image, metaphone_length)
+//   --> number of words, true if loaded from the image
+
+static int Lspell_load (lua_State *L)
+  {
+vector<string> vFiles;
+int i;
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  string strImage (luaL_checkstring (L, 2));
+  const int iMetaphoneLength = luaL_optinteger (L, 3, 4);
+
+  for (i = 1; ; i++)
+    {
+    lua_rawgeti (L, 1, i);   // get i'th item
+    if (lua_isnil (L, -1))
+      {
+      lua_pop (L, 1);
+      break;    // first nil key, leave loop
+      }
+    if (!lua_isstring (L, -1))
+      luaL_error (L, "dictionary file name %d must be a string", i);
+    vFiles.push_back (lua_tostring (L, -1));
+    lua_pop (L, 1); // remove value
+    }
+
+  bool bFromImage;
+  string strError;
+
+  if (!App.m_SpellDictionary.Load (vFiles, strImage, iMetaphoneLength, bFromImage, strError))
+    luaL_error (L, "%s", strError.c_str ());
+
+  lua_pushinteger (L, App.m_SpellDictionary.GetCount ());
+  lua_pushboolean (L, bFromImage);
+  return 2;
+  } // end of Lspell_load
+
+// spell.add (word) - add to the dictionary (and the image)
+
+static int Lspell_add (lua_State *L)
+  {
+  App.m_SpellDictionary.AddUserWord (luaL_checkstring (L, 1));
+  return 0;
+  } // end of Lspell_add
+
+// spell.check (word, case_sensitive) --> true if in dictionary
+
+static int Lspell_check (lua_State *L)
+  {
+  lua_pushboolean (L, App.m_SpellDictionary.IsWord (luaL_checkstring (L, 1),
+                                                    optboolean (L, 2, 0)));
+  return 1;
+  } // end of Lspell_check
+
+// spell.suggest (word, distance, case_sensitive) --> table of suggestions, best first
+
+static int Lspell_suggest (lua_State *L)
+  {
+vector<string> vSuggestions;
+vector<string>::const_iterator it;
+int i;
+
+  App.m_SpellDictionary.Suggest (luaL_checkstring (L, 1),
+                                 luaL_optinteger (L, 2, 4),
+                                 optboolean (L, 3, 0),
+                                 vSuggestions);
+
+  lua_createtable (L, (int) vSuggestions.size (), 0);
+
+  for (it = vSuggestions.begin (), i = 1; it != vSuggestions.end (); it++, i++)
+    {
+    lua_pushstring (L, it->c_str ());
+    lua_rawseti (L, -2, i);
+    }
+
+  return 1;
+  } // end of Lspell_suggest
+
+
+/* Open the library */
+
+static const luaL_Reg spell_lib[] = {
+  {"add",     Lspell_add},
+  {"check",   Lspell_check},
+  {"load",    Lspell_load},
+  {"suggest", Lspell_suggest},
+  {NULL, NULL}
+};
+
+LUALIB_API int luaopen_spell(lua_State *L)
+{
+  luaL_register (L, "spell", spell_lib);
+  return 1;
+}
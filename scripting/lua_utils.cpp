@@ -1027,7 +1027,11 @@ CDC dc;
 
 static int edit_distance (lua_State *L) 
   {
-  lua_pushinteger (L, EditDistance (luaL_checkstring (L, 1), luaL_checkstring (L, 2)));
+size_t sourcelen, targetlen;
+  const char * source = luaL_checklstring (L, 1, &sourcelen);
+  const char * target = luaL_checklstring (L, 2, &targetlen);
+
+  lua_pushinteger (L, EditDistance (source, sourcelen, target, targetlen, INT_MAX));
   return 1;
 }   // end of edit_distance
 
@@ -267,6 +267,9 @@ if (++m_iExecutionDepth > MAX_EXECUTION_DEPTH)
 
 CString strFixedCommand = Command;
 
+// whatever this command sends goes out together
+CSendBatch batch (this);
+
 // huh?  ASSERT (m_CurrentPlugin == NULL); 
 
 m_CurrentPlugin = NULL;
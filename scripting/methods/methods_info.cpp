@@ -27,7 +27,9 @@
 //    GetLineCount
 //    GetLineInfo
 //    GetLinesInBufferCount
+//    GetLinesMatching
 //    GetMainWindowPosition
+//    GetMXPMessageCount
 //    GetNotes
 //    GetReceivedBytes
 //    GetScriptTime
@@ -332,6 +334,12 @@ tInfoTypeMapping InfoTypes [] =
 // more numbers
 
 { 310, "Newlines received" },
+{ 311, "Triggers skipped by prefilter" },
+{ 312, "Socket reads per second" },
+{ 313, "Average incoming batch size" },
+{ 314, "Output buffer bytes per line" },
+{ 315, "MXP messages suppressed" },
+{ 316, "Socket writes" },
 
 
  { 0, "" }, // end of table marker
@@ -1096,6 +1104,48 @@ VARIANT CMUSHclientDoc::GetInfo(long InfoType)
         SetUpVariantLong (vaResult, m_newlines_received);  // newlines received
         break;
 
+    case 311:
+        SetUpVariantLong (vaResult, m_iTriggersPrefilteredCount);  // triggers skipped by prefilter
+        break;
+
+    case 312:
+      {
+      // reads in the last complete second (none if it was a while ago)
+      DWORD iElapsed = GetTickCount () - m_iReadsSecondStart;
+      if (iElapsed >= 2000)
+        SetUpVariantLong (vaResult, 0);
+      else if (iElapsed >= 1000)
+        SetUpVariantLong (vaResult, m_iReadsThisSecond);
+      else
+        SetUpVariantLong (vaResult, m_iReadsLastSecond);
+      }
+      break;
+
+    case 313:
+      if (m_iIncomingBatchCount)
+        SetUpVariantDouble (vaResult, (double) m_nIncomingBatchBytes / (double) m_iIncomingBatchCount);
+      else
+        SetUpVariantDouble (vaResult, 0);
+      break;
+
+    case 314:
+      // lines, styles and text (see LineArena.h)
+      if (m_LineList.GetCount ())
+        SetUpVariantLong (vaResult, (long) ((m_LineArena.GetBytesAllocated () + 
+                                             m_TextArena.GetBytesAllocated ()) / 
+                                             m_LineList.GetCount ()));
+      else
+        SetUpVariantLong (vaResult, 0);
+      break;
+
+    case 315:
+      SetUpVariantLong (vaResult, (long) m_iMXPmessagesSuppressed);  // MXP messages nobody would have seen
+      break;
+
+    case 316:
+      SetUpVariantLong (vaResult, (long) m_iOutputWriteCount);  // compare to packets sent (205)
+      break;
+
     default:
       vaResult.vt = VT_NULL;
       break;
@@ -1245,6 +1295,132 @@ long CMUSHclientDoc::GetLinesInBufferCount()
 	return m_LineList.GetCount ();
 }   // end of CMUSHclientDoc::GetLinesInBufferCount
 
+// world.GetLinesMatching (Text, MatchCase, Regexp)
+//
+//  returns an array of the line numbers (as for GetLineInfo) of the first line of each
+//  paragraph in the output buffer which contains Text (or matches it, if Regexp)
+//  returns "EMPTY" if none found, or a bad regular expression
+
+VARIANT CMUSHclientDoc::GetLinesMatching(LPCTSTR Text, BOOL MatchCase, BOOL Regexp) 
+{
+  COleSafeArray sa;   // for list
+  CString strFind = Text;
+  t_regexp * regexp = NULL;
+  CTextSignature signature;   // trigrams a matching paragraph must have
+  vector<long> vLines;
+
+  if (strFind.IsEmpty ())
+    return sa.Detach ();
+
+  try
+    {
+    signature.Clear ();
+
+    if (Regexp)
+      {
+      regexp = regcomp (Text, (MatchCase ? 0 : PCRE_CASELESS) | (m_bUTF_8 ? PCRE_UTF8 : 0));
+      // see FindRoutine - the literal must be in every match, or we skip paragraphs which match
+      signature.Add (NULL, 0, 
+                     regexp->m_sRequiredLiteral.c_str (), 
+                     regexp->m_sRequiredLiteral.size ());
+      }
+    else
+      {
+      // see FindRoutine
+      signature.Add (NULL, 0, strFind, strFind.GetLength (), !MatchCase);
+      if (!MatchCase)
+        strFind.MakeLower ();
+      }
+
+    CString strLine;
+    CTextSignature paragraph;
+    POSITION pos = m_LineList.GetHeadPosition ();
+    long nLine = 0;
+
+    while (pos)
+      {
+      POSITION startpos = pos;
+      long nStartLine = nLine;
+
+      // find the end of this paragraph, and what it might contain (see TextSignature.h)
+      paragraph.Clear ();
+      while (pos)
+        {
+        CLine * pLine = m_LineList.GetNext (pos);
+        paragraph.Merge (pLine->m_signature);
+        nLine++;
+        if (pLine->hard_return)
+          break;
+        }
+
+      if (!paragraph.MightContain (signature))
+        continue;   // can't be in there
+
+      // it might be - assemble the text and look properly
+      strLine.Empty ();
+      for (POSITION linepos = startpos; linepos != pos; )
+        {
+        CLine * pLine = m_LineList.GetNext (linepos);
+        strLine += CString (pLine->text, pLine->len);
+        }
+
+      bool bFound;
+
+      if (regexp)
+        bFound = regexec (regexp, strLine, 0);
+      else
+        {
+        if (!MatchCase)
+          strLine.MakeLower ();
+        bFound = strLine.Find (strFind) != -1;
+        }
+
+      if (bFound)
+        vLines.push_back (nStartLine + 1);   // line numbers are 1-relative
+
+      } // end of each paragraph
+
+    }   // end of try block
+
+  catch (CException* e)
+    {
+    e->Delete ();
+    delete regexp;
+    return sa.Detach ();
+    }
+
+  delete regexp;
+
+  if (!vLines.empty ())  // cannot create empty array dimension
+    {
+    sa.CreateOneDim (VT_VARIANT, vLines.size ());
+
+    for (long i = 0; i < vLines.size (); i++)
+      {
+      COleVariant v (vLines [i]);
+      sa.PutElement (&i, &v);
+      }
+    } // end of having at least one
+
+	return sa.Detach ();
+}   // end of CMUSHclientDoc::GetLinesMatching
+
+
+// world.GetMXPMessageCount (MessageNumber)
+//
+//  returns how many times this MXP error, warning, info or debug message has been
+//  raised since MXP was last turned on - whether or not the debug level let it be shown
+
+long CMUSHclientDoc::GetMXPMessageCount(long MessageNumber) 
+{
+  map<long, long>::const_iterator it = m_MXPmessageCounts.find (MessageNumber);
+
+  if (it == m_MXPmessageCounts.end ())
+    return 0;
+
+	return it->second;
+}   // end of CMUSHclientDoc::GetMXPMessageCount
+
 
 // world.GetStyleInfo (LineNumber, StyleNumber, InfoType) - gets details about the style
 //                                     returns "EMPTY" if line or style number out of range
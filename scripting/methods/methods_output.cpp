@@ -246,10 +246,6 @@ POSITION pos;
 // delete all lines in this set
   for (pos = m_LineList.GetTailPosition (); Count > 0 && pos; Count--)
    {
-   // if this particular line was added to the line positions array, then make it null
-    if (m_LineList.GetCount () % JUMP_SIZE == 1)
-          m_pLinePositions [m_LineList.GetCount () / JUMP_SIZE] = NULL;
-
     delete m_LineList.GetTail (); // delete contents of tail iten -- version 3.85
     m_LineList.RemoveTail ();   // get rid of the line
     m_total_lines--;            // don't count as received
@@ -257,7 +253,7 @@ POSITION pos;
    if (m_LineList.IsEmpty ())  // give up if buffer is empty
      break;
 
-   m_LineList.GetPrev (pos);
+   pos = m_LineList.GetTailPosition ();   // the one before is now the tail
    }
 
   // try to allow world.tells to span omitted lines
@@ -267,6 +263,8 @@ POSITION pos;
     if (((m_pCurrentLine->flags & COMMENT) == 0) ||
         m_pCurrentLine->hard_return)
         m_pCurrentLine = NULL;
+    else
+      m_pCurrentLine->m_signature.SetAll ();   // it isn't finished after all
     }
   else
     m_pCurrentLine = NULL;
@@ -274,16 +272,15 @@ POSITION pos;
   if (!m_pCurrentLine)
     {
     // restart with a blank line at the end of the list
-    m_pCurrentLine = new CLine (++m_total_lines, 
-                                m_nWrapColumn,
-                                m_iFlags,
-                                m_iForeColour,
-                                m_iBackColour,
-                                m_bUTF_8);
-    pos = m_LineList.AddTail (m_pCurrentLine);
-
-    if (m_LineList.GetCount () % JUMP_SIZE == 1)
-      m_pLinePositions [m_LineList.GetCount () / JUMP_SIZE] = pos;
+    m_pCurrentLine = NewLine (++m_total_lines, 
+                              m_nWrapColumn,
+                              m_iFlags,
+                              m_iForeColour,
+                              m_iBackColour,
+                              m_bUTF_8,
+                              m_LineArena,
+                              m_TextArena);
+    m_LineList.AddTail (m_pCurrentLine);
     }
 
 // notify view that we have "added" stuff (deleted, really)
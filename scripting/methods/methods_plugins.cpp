@@ -526,6 +526,7 @@ CPlugin * pPlugin = GetPlugin (PluginID);
     return eOK;   // already same state
 
   pPlugin->m_bEnabled = Enabled != 0;
+  PluginSubscribersChanged ();
 
   CPlugin * pSavedPlugin = m_CurrentPlugin;
 
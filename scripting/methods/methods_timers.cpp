@@ -102,6 +102,8 @@ CTimer * Timer_item;
   Timer_item->bEnabled = Enabled != 0;                // set enabled flag
   Timer_item->nUpdateNumber   = App.GetUniqueNumber ();   // for concurrency checks
 
+  GetTimerQueue ().Schedule (Timer_item);   // back in the queue if now enabled
+
   if (!m_CurrentPlugin) // plugin mods don't really count
     SetModifiedFlag (TRUE);   // document has changed
   return eOK;
@@ -512,7 +514,8 @@ CTimer * timer_item;
 
   ResetOneTimer (timer_item);
 
-  SortTimers ();
+  // just add this one to the reverse map - DoAfter may be called a lot
+  GetTimerRevMap () [timer_item] = (LPCTSTR) strTimerName;
 
 	return eOK;
 }   // end of CMUSHclientDoc::DoAfterSpecial
@@ -588,6 +591,7 @@ long CMUSHclientDoc::EnableTimerGroup(LPCTSTR GroupName, BOOL Enabled)
     if (timer_item->strGroup == GroupName)
       {
       timer_item->bEnabled = Enabled != 0;
+      GetTimerQueue ().Schedule (timer_item);   // ignored if disabled
       iCount++;
       }
     }   // end of timers
@@ -815,6 +819,7 @@ bool bChanged;
       if (!m_CurrentPlugin) // plugin mods don't really count
         SetModifiedFlag (TRUE);   // document has changed
       Timer_item->nUpdateNumber    = App.GetUniqueNumber ();   // for concurrency checks
+      GetTimerQueue ().Schedule (Timer_item);   // in case it was enabled
       }
 
     if (iResult == eOK && Timer_item->iType == CTimer::eInterval)
@@ -510,6 +510,11 @@ CTrigger * trigger_item;
         SetUpVariantLong   (vaResult, trigger_item->regexp->m_iMatchAttempts);
       break;
 
+    case  39: // how the regexp is executed (interpreter, jit, dfa or literal)
+      if (trigger_item->regexp)
+        SetUpVariantString (vaResult, trigger_item->regexp->GetBackendName ());
+      break;
+
 #ifdef PANE
     case  38: SetUpVariantString (vaResult, trigger_item->strPane); break;
 #endif // PANE
@@ -43,6 +43,8 @@ long nStatus;
   variable_item->strLabel = VariableName;
   variable_item->strContents = Contents;
 
+  NoteVariableChanged (strVariableName);
+
 	return eOK;
 }    // end of CMUSHclientDoc::SetVariable
 
@@ -129,6 +131,8 @@ long nStatus;
   if (!GetVariableMap ().RemoveKey (strVariableName))
     return eVariableNotFound;
 
+  NoteVariableChanged (strVariableName);
+
   if (!m_CurrentPlugin) // plugin mods don't really count
     SetModifiedFlag (TRUE);   // document has changed
 
@@ -229,9 +229,9 @@ BSTR CMUSHclientDoc::ExportXML(short Type, LPCTSTR Name)
 void CMUSHclientDoc::SetEntity(LPCTSTR Name, LPCTSTR Contents) 
 {
   if (strlen (Contents) == 0)
-    m_CustomEntityMap.RemoveKey (Name);
+    MXP_RemoveCustomEntity (Name);
   else
-    m_CustomEntityMap.SetAt (Name, Contents);
+    MXP_SetCustomEntity (Name, Contents);
  
 }   // end of CMUSHclientDoc::SetEntity
 
@@ -14,6 +14,7 @@ extern "C"
 #include "paneline.h"
 
 #define DOCUMENT_STATE "mushclient.document"
+#define CALLBACKS_STATE "mushclient.callbacks"
 #define WORLD_LIBRARY "world"
 
 void LuaError (lua_State *L, 
@@ -110,6 +111,11 @@ class CScriptEngine : public CObject
 
   CString               m_strLanguage;        // language, (vbscript, jscript, perlscript)
 
+  // Lua: function name to its reference in the CALLBACKS_STATE table
+  map<string, DISPID>   m_LuaCallbacks;
+
+  bool PushLuaFunction (const DISPID dispid, LPCTSTR szProcedure);
+
   };
 
 int RegisterLuaRoutines (lua_State * L);
@@ -6,10 +6,9 @@
   Updated: 13th April 2007 to added IGNORE_MIXED_CASE, IGNORE_IMBEDDED_NUMBERS
   Updated: 15th February 2009 to convert to using SQLite database instead of Lua table
   Updated: 21st February 2009 to fix problem where words with 2 metaphones were only stored once.
+  Updated: 17th October 2026 to use the built-in dictionary (spell.xxx) instead of SQLite
 --]]
 
-local SHOW_PROGRESS_BAR = true -- show progress bar? true or false
-
 local METAPHONE_LENGTH = 4   -- how many characters of metaphone to get back
 local EDIT_DISTANCE = 4      -- how close a word must be to appear in the list of suggestions
 local CASE_SENSITIVE = false -- compare case? true or false
@@ -24,10 +23,10 @@ local pattern = "%a+'?[%a%d]+" -- regexp to give us a word with a possible singl
 local directory = utils.info ().app_directory .. "spell\\"
 -- file name of the user dictionary, in the above path
 local userdict = "userdict.txt"
+-- file name of the dictionary image (rebuilt if any dictionary changes), in the above path
+local image = "spell.dic"
 
 -- stuff below used internally
-local make_upper  -- this becomes the upper-case conversion function, see below
-local db          -- SQLite3 dictionary database
 local cancelmessage = "spell check cancelled"
 local previousword  --> not used right now
 local change, ignore  -- tables of change-all, ignore-all words
@@ -67,43 +66,36 @@ local function trim (s)
   return (string.gsub (s, "^%s*(.-)%s*$", "%1"))
 end -- trim
 
--- insert a word into our metaphone table - called by reading dictionaries
--- and also by adding a word during the spellcheck
-local function insert_word (word, user)
-  
+-- append words to the user dictionary file
+local function append_to_userdict (words)
+
+  -- make sure we start on a new line
+  local f = assert (io.open (directory .. userdict, "r"))
+  local contents = f:read ("*a")
+  f:close ()
+
+  f = assert (io.open (directory .. userdict, "a"))
+  if contents ~= "" and not string.match (contents, "\n$") then
+    f:write ("\n")
+  end -- no newline at end
+  for _, word in ipairs (words) do
+    f:write (word, "\n")
+  end -- for each word
+  f:close ()
+
+end -- append_to_userdict
+
+-- add a word during the spellcheck - to the user dictionary, and the one in memory
+local function insert_word (word)
+
   if word == "" then
     return
   end -- empty word
-  
-              
-  -- get both metaphones
-  local m1, m2 = utils.metaphone (word, METAPHONE_LENGTH)
-  local fixed_word = string.gsub (word, "'", "''")  -- convert ' to ''
-  
-  assert (db:execute (string.format ("INSERT INTO words VALUES (NULL, '%s', '%s', %i)",
-            fixed_word, m1, user)));
-    
-  -- do 2nd metaphone, if any
-   if m2 then
-    assert (db:execute (string.format ("INSERT INTO words VALUES (NULL, '%s', '%s', %i)",
-              fixed_word, m2, user)));
-   end -- having alternative      
-  
-end -- insert_word
 
+  append_to_userdict { word }
+  spell.add (word)
 
--- sort function for sorting the suggestions into edit-distance order
-local function suggestions_compare (word)
-   return function (a, b)
-     local diff = utils.edit_distance (make_upper (a), word) - 
-                  utils.edit_distance (make_upper (b), word) 
-     if diff == 0 then
-       return make_upper (a) < make_upper (b)
-     else
-       return diff < 0
-     end -- differences the same?
-  end -- compareit
-end -- function suggestions_compare
+end -- insert_word
 
 -- check for one word, called by spellcheck (invokes suggestion dialog)
 local function checkword_and_suggest (word)
@@ -130,8 +122,6 @@ local function checkword_and_suggest (word)
     end -- this round, ignore this word
   end -- if IGNORE_IMBEDDED_NUMBERS
 
-  uc_word = make_upper (word)  -- convert to upper-case if wanted
-
   -- if we already did "ignore all" on this particular word, ignore it again
   if ignore [word] then
     return word, "ignore"
@@ -142,46 +132,13 @@ local function checkword_and_suggest (word)
     return change [word], "change"
   end -- change to this word
   
-  -- table of suggestions, based on the metaphone
-  local keyed_suggestions = {}
-  
-  -- get both metaphones
-  local m1, m2 = utils.metaphone (word, METAPHONE_LENGTH)
-  
-  local function lookup_metaphone (m)
-    local found = false
-    for row in db:rows(string.format ("SELECT name FROM words WHERE metaphone = '%s'", m)) do
-      local word = row [1]
-      if make_upper (word) == uc_word then
-        found = true -- found exact match
-        break
-      end  -- found
-      if utils.edit_distance (make_upper (word), uc_word) < EDIT_DISTANCE then
-        keyed_suggestions [word] = true
-      end -- close enough
-    end
-    return found
-  end -- lookup_metaphone
-  
-  -- look up first metaphone
-  if lookup_metaphone (m1) then
+  -- in the dictionary?
+  if spell.check (word, CASE_SENSITIVE) then
     return word, "ok"
   end -- word found
 
-  -- try 2nd metaphone
-  if m2 then
-    if lookup_metaphone (m2) then
-      return word, "ok"
-    end -- word found
-  end -- have alternate metaphone
-
-  -- pull into indexed table
-  local suggestions = {}
-  for k in pairs (keyed_suggestions) do
-    table.insert (suggestions, k)
-  end -- for 
-     
-  table.sort (suggestions, suggestions_compare (uc_word))
+  -- words with the same metaphone, in edit-distance order
+  local suggestions = spell.suggest (word, EDIT_DISTANCE, CASE_SENSITIVE)
   
   -- not found? do spell check dialog
   local action, replacement = utils.spellcheckdialog (word, suggestions)
@@ -203,9 +160,9 @@ local function checkword_and_suggest (word)
   end -- ignore word
 
   -- add to user dictionary? 
-  -- add to metaphone table, and rewrite dictionary
+  -- add to dictionary in memory, and user dictionary file
   if action == "add" then
-    insert_word (word, 1)
+    insert_word (word)
     return word, "ok"
   end -- adding
   
@@ -252,21 +209,10 @@ local notfound  -- table of not-found words, for spellcheck_string
 
 -- check for one word, called by spellcheck_string
 local function checkword (word)
-  uc_word = make_upper (word)  -- convert to upper-case if wanted
 
-  -- get first metaphone 
-  local m = utils.metaphone (word, METAPHONE_LENGTH)
-  
-  local found = false
-  for row in db:rows(string.format ("SELECT name FROM words WHERE metaphone = '%s'", m)) do
-    local word = row [1]
-    if make_upper (word) == uc_word then
-      found = true -- found exact match
-      break
-    end  -- found
-  end
-  
-  if found then return end  -- do nothing if word found
+  if spell.check (word, CASE_SENSITIVE) then 
+    return   -- do nothing if word found
+  end -- found
 
   -- otherwise insert our word   
   table.insert (notfound, word) 
@@ -282,33 +228,41 @@ end -- spellcheck_string
 -- exported function to add a word to the user dictionary
 function spellcheck_add_word (word, action, replacement)
   assert (action == "i", "Can only use action 'i' in user dictionary")  -- only "i" supported right now
-  insert_word (word, 1)
+  insert_word (word)
 end -- spellcheck_string
 
--- read one of the dictionaries
-local function read_dict (dlg, name)
- if SHOW_PROGRESS_BAR then
-   dlg:step ()
-   dlg:status (directory .. name)
-   if dlg:checkcancel () then
-     error "Dictionary loading cancelled"
-   end -- if cancelled
- end -- if SHOW_PROGRESS_BAR
-
-  for line in io.lines (directory .. name) do
-    insert_word (line, 0)
-  end 
-end -- read_dict
+-- words added with earlier versions only went into the SQLite database
+-- (spell.sqlite), so copy them to the user dictionary, and retire the database
+local function import_database_words ()
+  local name = directory .. "spell.sqlite"
+  
+  local f = io.open (name, "r")
+  if not f then
+    return
+  end -- no database
+  f:close ()
+  
+  local words = {}
+  local db = sqlite3.open (name)
+  if db then
+    pcall (function ()
+      for row in db:nrows ("SELECT DISTINCT name FROM words WHERE user = 1") do 
+        table.insert (words, row.name)
+      end -- for each user word
+    end) -- no words table is OK
+    db:close ()
+  end -- if opened
   
+  if #words > 0 then
+    append_to_userdict (words)
+  end -- if any
+  
+  os.remove (name .. ".old")
+  os.rename (name, name .. ".old")
+end -- import_database_words
+
 local function init ()
 
-  -- make a suitable function depending on whether they want case-sensitive or not
-  if CASE_SENSITIVE then
-    make_upper = function (s) return s end -- return original
-  else
-    make_upper = function (s) return s:upper () end  -- make upper case
-  end -- case-sensitivity test
-  
   -- if no user dictionary, create it
   local f = io.open (directory .. userdict, "r")
   if not f then
@@ -317,77 +271,18 @@ local function init ()
   else
     f:close ()
   end -- checking for user dictionary
- 
-  -- open database on disk
-  db = assert (sqlite3.open( directory .. "spell.sqlite"))
-  local words_table = false
-  local count = 0
-  
-  -- if database just created, there won't be a words table
-  for row in db:nrows("SELECT * FROM sqlite_master WHERE type = 'table' AND name = 'words'") do 
-    if string.match (row.sql, "word_id") then  -- better be newer version
-      words_table = true
-    end -- if
-  end
   
-  -- enable WAL (Write-Ahead Logging)
-  assert (db:execute "PRAGMA journal_mode=WAL;")
-  
-  -- if no words table, make one
-  if not words_table then
-      -- create a table to hold the words
-    assert (db:execute[[
-      DROP TABLE IF EXISTS words;
-      CREATE TABLE words(
-        word_id INTEGER NOT NULL PRIMARY KEY autoincrement,
-        name  VARCHAR(10) NOT NULL,
-        metaphone VARCHAR(10) NOT NULL,
-        user INT(1)
-      );
-      CREATE INDEX metaphone_index ON words (metaphone);
-      CREATE INDEX name_index ON words (name);
-    ]])
-  end -- if 
-    
-  -- check if table empty
-  for row in db:rows('SELECT COUNT(*) FROM words') do 
-    count = row [1] 
-  end
-
-  -- if empty, populate it  
-  if count == 0 then
-    
-    local dlg
-  
-    if SHOW_PROGRESS_BAR then
-      dlg = progress.new ("Loading dictionaries into SQLite database ...")
-    
-      dlg:range (0, #files)
-      dlg:setstep (1)
-    end -- if SHOW_PROGRESS_BAR
-     
-    assert (db:execute "BEGIN TRANSACTION");
-    
-    for k, v in ipairs (files) do
-      ok, result = pcall (function () 
-                            read_dict (dlg, v) 
-                          end)
-      if not ok then 
-        if SHOW_PROGRESS_BAR then
-          dlg:close ()
-        end -- if SHOW_PROGRESS_BAR
-        error (result)
-      end -- not ok
-    end -- reading each file
-    
-    if SHOW_PROGRESS_BAR then
-      dlg:close ()
-    end -- if SHOW_PROGRESS_BAR
-    
-    assert (db:execute "COMMIT");
-    
-  end -- if nothing in database
+  import_database_words ()
+ 
+  -- full pathnames of the dictionaries
+  local pathnames = {}
+  for _, v in ipairs (files) do
+    table.insert (pathnames, directory .. v)
+  end -- for each dictionary
   
+  -- loads the image if it is up-to-date, otherwise reads the dictionaries
+  -- (slowly) and writes a new image
+  spell.load (pathnames, directory .. image, METAPHONE_LENGTH)
   
 end -- init
 
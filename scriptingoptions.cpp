@@ -138,7 +138,7 @@ tConfigurationNumericOption OptionsTable [] = {
 {"log_script_errors",                   false, O(m_bLogScriptErrors)},           
 {"lower_case_tab_completion",           false, O(m_bLowerCaseTabCompletion)},           
 {"map_failure_regexp",                  false, O(m_bMapFailureRegexp)},                 
-{"max_output_lines",                    5000,  O(m_maxlines), 200, 500000, OPT_FIX_OUTPUT_BUFFER},            
+{"max_output_lines",                    5000,  O(m_maxlines), 200, 1000000, OPT_FIX_OUTPUT_BUFFER},            
 {"mud_can_change_link_colour",          true,  O(m_bMudCanChangeLinkColour), 0, 0, OPT_SERVER_CAN_WRITE},           
 {"mud_can_remove_underline",            false, O(m_bMudCanRemoveUnderline), 0, 0, OPT_SERVER_CAN_WRITE},            
 {"mud_can_change_options",              true,  O(m_bMudCanChangeOptions)},            
@@ -530,24 +530,8 @@ long iResult = SetBaseOptionItem (iItem,
   if (OptionsTable [iItem].iFlags & OPT_FIX_WRAP_COLUMN)
     {
     if (m_pCurrentLine)     // a new world might not have a line yet
-      {
-      // save current line text
-      CString strLine = CString (m_pCurrentLine->text, m_pCurrentLine->len);
-
-#ifdef USE_REALLOC
-      m_pCurrentLine->text  = (char *) 
-            realloc (m_pCurrentLine->text, 
-                     MAX (m_pCurrentLine->len, Value) 
-                     * sizeof (char));  
-#else
-      delete [] m_pCurrentLine->text;
-      m_pCurrentLine->text = new char [MAX (m_pCurrentLine->len, Value)];
-#endif
-
-      // put text back
-      memcpy (m_pCurrentLine->text, (LPCTSTR) strLine, m_pCurrentLine->len);
-      ASSERT (m_pCurrentLine->text);
-      }   // end of having a current line
+      m_pCurrentLine->ResizeText (m_TextArena,
+                                  MAX (m_pCurrentLine->len, Value) * (m_bUTF_8 ? 4 : 1));
     SendWindowSizes (Value);
     }
 
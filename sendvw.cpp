@@ -1481,7 +1481,8 @@ CMUSHclientDoc* pDoc = (CMUSHclientDoc*) pObject;
 CLine * pLine;
 POSITION prevpos = NULL;
 
-  if (FindInfo.m_pFindPosition == NULL)
+  // skip paragraphs which can't contain what we want (see TextSignature.h)
+  if (SkipToCandidate (pDoc, FindInfo))
     return true;          // no more lines
 
   // if doing backwards, we must go back a whole *line* (ie. the one after a hard return)
@@ -1538,6 +1539,65 @@ POSITION prevpos = NULL;
   return false;
   } // end of CSendView::GetNextLine
 
+// Moves FindInfo.m_pFindPosition past paragraphs which cannot match, as
+// if they had been fetched by GetNextLine and not matched.
+// Returns true if we run out of lines.
+
+bool CSendView::SkipToCandidate (CMUSHclientDoc * pDoc,
+                                 CFindInfo & FindInfo)
+  {
+CLine * pLine;
+POSITION pos;
+CTextSignature signature;
+long nLines;
+
+  while (FindInfo.m_pFindPosition)
+    {
+    signature.Clear ();
+    nLines = 0;
+
+    if (FindInfo.m_bForwards)
+      {
+      // this paragraph runs from here to the next hard return
+      for (pos = FindInfo.m_pFindPosition; pos; )
+        {
+        pLine = pDoc->m_LineList.GetNext (pos);
+        signature.Merge (pLine->m_signature);
+        nLines++;
+        if (pLine->hard_return)
+          break;
+        }
+
+      if (signature.MightContain (FindInfo.m_signature))
+        return false;   // worth looking at
+
+      FindInfo.m_pFindPosition = pos;
+      FindInfo.m_nCurrentLine += nLines;
+      }
+    else
+      {
+      // this paragraph ends here, and starts after the previous hard return
+      pos = FindInfo.m_pFindPosition;
+      do
+        {
+        pLine = pDoc->m_LineList.GetPrev (pos);
+        signature.Merge (pLine->m_signature);
+        nLines++;
+        } while (pos && !pDoc->m_LineList.GetAt (pos)->hard_return);
+
+      if (signature.MightContain (FindInfo.m_signature))
+        return false;   // worth looking at
+
+      FindInfo.m_pFindPosition = pos;
+      FindInfo.m_nCurrentLine -= nLines;
+      }
+
+    } // end of while we have lines
+
+  return true;    // ran out
+
+  } // end of CSendView::SkipToCandidate
+
 void CSendView::OnDisplayFind() 
 {
   DoFind (false);
@@ -107,6 +107,8 @@ protected:
   static void InitiateSearch (const CObject * pObject,
                               CFindInfo & FindInfo);
  
+  static bool SkipToCandidate (CMUSHclientDoc * pDoc,
+                               CFindInfo & FindInfo);
   static bool GetNextLine (const CObject * pObject,
                            CFindInfo & FindInfo, 
                            CString & strLine);
@@ -75,7 +75,7 @@ void CMUSHclientDoc::Serialize(CArchive& ar)
     {
     try
       {
-      m_MapFailureRegexp = regcomp (m_strMappingFailure, (m_bUTF_8 ? PCRE_UTF8 : 0));
+      m_MapFailureRegexp = regcomp (m_strMappingFailure, (m_bUTF_8 ? PCRE_UTF8 : 0), true);  // match only
       }
     catch (CException* e)
       {
@@ -114,6 +114,7 @@ using namespace std ;
 bool IsStringNumber (const string & s, const bool bSigned = false);
 
 #include "regexp.h"
+#include "TextSignature.h"   // for finding text quickly
 #include "mcdatetime.h" // MUSHclient date/time class
 
 #include "sqlite3\sqlite3.h"  // SQLite3 database 
@@ -175,7 +176,6 @@ class CActivityDlg;
 class CMUSHView;
 class CMUSHclientDoc;
 
-//#define USE_REALLOC   // use malloc/realloc/free for line text
 
 // The define below gets the current app and casts it to the correct type
 
@@ -271,6 +271,7 @@ class CFindInfo : public CObject
     m_iControlColumns = 0;
     m_regexp = NULL;
     m_bRepeatOnSameLine = false;
+    m_signature.Clear ();
     };                 // constructor
 
   ~CFindInfo () { delete m_regexp; };
@@ -293,6 +294,7 @@ class CFindInfo : public CObject
   CStringList m_strFindStringList;  // previous things we found
   bool m_bRepeatOnSameLine;     // keep trying to match on same line
   list<pair<int, int> >  m_MatchesOnLine;  // list of matches on this line
+  CTextSignature m_signature;   // trigrams a matching line must contain
   };
 
 // prototype for "get next line" callback for find routine
@@ -518,8 +520,9 @@ do {                      \
 #define TOGGLE_BIT(var, bit)	((var) ^= (bit))
 
 class CStyle;
+class CLineArena;
 
-CStyle * GetNewStyle (const char * filename, const long linenumber);
+CStyle * GetNewStyle (CLineArena & arena, const char * filename, const long linenumber);
 void DeleteStyle (CStyle * pStyle, const char * filename, const long linenumber);
 
 // ANSI Colour Codes
@@ -626,16 +629,16 @@ enum
               _CrtSetDbgFlag((a) | _CrtSetDbgFlag(_CRTDBG_REPORT_FLAG))
   #define  CLEAR_CRT_DEBUG_FIELD(a) \
               _CrtSetDbgFlag(~(a) & _CrtSetDbgFlag(_CRTDBG_REPORT_FLAG))
-//  #define NEWSTYLE GetNewStyle (__FILE__, __LINE__)
+//  #define NEWSTYLE GetNewStyle (m_LineArena, __FILE__, __LINE__)
 //  #define DELETESTYLE(arg) DeleteStyle (arg, __FILE__, __LINE__)
-  #define NEWSTYLE new CStyle
+  #define NEWSTYLE NewStyle (m_LineArena)
   #define DELETESTYLE(arg) delete arg
 
 #else
   #define  SET_CRT_DEBUG_FIELD(a)   ((void) 0)
   #define  CLEAR_CRT_DEBUG_FIELD(a) ((void) 0)
 
-  #define NEWSTYLE new CStyle
+  #define NEWSTYLE NewStyle (m_LineArena)
   #define DELETESTYLE(arg) delete arg
 #endif
 
@@ -725,7 +728,10 @@ void FindMatchingBrace (CEdit & ctlEdit, const bool bSelect);
 void GetButtonSize (CWnd & ctlWnd, int & iHeight, int & iWidth);
 
 void metaphone (const char *name, char * metaph, int metalen);
-int EditDistance (const string source, const string target);
+int EditDistance (const string & source, const string & target);
+int EditDistance (const char * source, const size_t iSourceLength,
+                  const char * target, const size_t iTargetLength,
+                  int iLimit);
 
 const char * Make_Absolute_Path (CString strFileName);
 const char * Convert_PCRE_Runtime_Error (const int iError);
@@ -11,6 +11,100 @@
 
 unsigned long CTimer::nNextCreateSequence = 0;
 
+// every timer in existence, by nCreateSequence, so queued timers can be checked
+//  - a function, so it is constructed before any timer needs it
+
+map<unsigned long, CTimer *> & CTimer::GetAllTimers (void)
+  {
+  static map<unsigned long, CTimer *> AllTimers;
+  return AllTimers;
+  } // end of CTimer::GetAllTimers
+
+CTimer * CTimer::FindTimer (const unsigned long nSequence)
+  {
+  map<unsigned long, CTimer *>::const_iterator it = GetAllTimers ().find (nSequence);
+
+  if (it == GetAllTimers ().end ())
+    return NULL;
+
+  return it->second;
+  } // end of CTimer::FindTimer
+
+void CTimerQueue::Schedule (const CTimer * pTimer)
+  {
+  tEntry entry;
+
+  if (!pTimer->bEnabled)
+    return;   // will be scheduled when enabled
+
+  entry.dFireTime = pTimer->tFireTime.GetTime ();
+  entry.nSequence = pTimer->nCreateSequence;
+
+  m_vHeap.push_back (entry);
+  push_heap (m_vHeap.begin (), m_vHeap.end ());
+  } // end of CTimerQueue::Schedule
+
+bool CTimerQueue::GetDue (const CmcDateTime & tNow, CTimer * & pTimer)
+  {
+  pTimer = NULL;
+
+  if (m_vHeap.empty () || m_vHeap.front ().dFireTime > tNow.GetTime ())
+    return false;   // nothing due
+
+  tEntry entry = m_vHeap.front ();
+  pop_heap (m_vHeap.begin (), m_vHeap.end ());
+  m_vHeap.pop_back ();
+
+  pTimer = CTimer::FindTimer (entry.nSequence);
+
+  // discard if deleted, disabled or rescheduled since
+  if (pTimer && 
+      (!pTimer->bEnabled || pTimer->tFireTime.GetTime () != entry.dFireTime))
+    pTimer = NULL;
+
+  return true;
+  } // end of CTimerQueue::GetDue
+
+void CTimerQueue::Defer (const CTimer * pTimer)
+  {
+  tEntry entry;
+
+  entry.dFireTime = pTimer->tFireTime.GetTime ();
+  entry.nSequence = pTimer->nCreateSequence;
+
+  m_vDeferred.push_back (entry);
+  } // end of CTimerQueue::Defer
+
+void CTimerQueue::Undefer (void)
+  {
+  for (vector<tEntry>::const_iterator it = m_vDeferred.begin (); 
+       it != m_vDeferred.end ();
+       it++)
+    {
+    m_vHeap.push_back (*it);
+    push_heap (m_vHeap.begin (), m_vHeap.end ());
+    }
+
+  m_vDeferred.clear ();
+  } // end of CTimerQueue::Undefer
+
+void CTimerQueue::Rebuild (CTimerMap & TimerMap)
+  {
+  CTimer * pTimer;
+  CString strTimerName;
+
+  m_vHeap.clear ();
+  m_vDeferred.clear ();
+
+  for (POSITION pos = TimerMap.GetStartPosition(); pos; )
+    {
+    TimerMap.GetNextAssoc (pos, strTimerName, pTimer);
+    Schedule (pTimer);
+    }
+
+  m_bRebuild = false;
+  } // end of CTimerQueue::Rebuild
+
 void CMUSHclientDoc::ResetOneTimer (CTimer * timer_item)
   {
 CmcDateTime tNow = CmcDateTime::GetTimeNow();
@@ -47,6 +141,9 @@ CmcDateTimeSpan tsOneDay (1, 0, 0, 0);
                                               timer_item->iOffsetMinute, 
                                               timer_item->fOffsetSecond);
 
+  // queue it for the new time
+  GetTimerQueue ().Schedule (timer_item);
+
   } // end of CMUSHclientDoc::ResetOneTimer
 
 void CMUSHclientDoc::ResetAllTimers (CTimerMap & TimerMap)
@@ -60,55 +157,56 @@ void CMUSHclientDoc::ResetAllTimers (CTimerMap & TimerMap)
     ResetOneTimer (pTimer);
     }
 
+  // get rid of old queue entries while we are at it
+  GetTimerQueue ().SetRebuild ();
+
   } // end of CMUSHclientDoc::ResetAllTimers
 
-void CMUSHclientDoc::CheckTimerList (CTimerMap & TimerMap)
+void CMUSHclientDoc::CheckTimerList (CTimerMap & TimerMap, CTimerQueue & TimerQueue)
   {
 CTimer * timer_item;
 CString strTimerName;
 CmcDateTime tNow = CmcDateTime::GetTimeNow();
 CmcDateTimeSpan tsOneDay (1, 0, 0, 0);
 
-// check for deleted chat sessions
-
-  for (POSITION chatpos = m_ChatList.GetHeadPosition (); chatpos; )
-    {
-    POSITION oldpos = chatpos;
-    CChatSocket * pSocket = m_ChatList.GetNext (chatpos);
-    if (pSocket->m_bDeleteMe)
-      {
-      m_ChatList.RemoveAt (oldpos);
-      delete pSocket;
-      break;    // list is no longer valid
-      }
-    }
-
   set <string> firedTimersList;
-  POSITION pos;
 
-// iterate through all timers for this document - first build list of them
+  // first time, or too many stale entries? start again
+  if (TimerQueue.NeedsRebuild (TimerMap))
+    TimerQueue.Rebuild (TimerMap);
 
-  for (pos = TimerMap.GetStartPosition(); pos; )
-    {
+  // timers which were waiting for us to connect can go now
+  if (m_iConnectPhase == eConnectConnectedToMud)
+    TimerQueue.Undefer ();
 
+// take the due timers off the queue - first build list of them
 
-    TimerMap.GetNextAssoc (pos, strTimerName, timer_item);
+  while (TimerQueue.GetDue (tNow, timer_item))
+    {
 
-    if (!timer_item->bEnabled)    // ignore un-enabled timers
-      continue;
+    if (timer_item == NULL)
+      continue;   // deleted, disabled or rescheduled since queued
 
-    // no timer activity whilst closed or in the middle of connecting, or if not enabled
+    // no timer activity whilst closed or in the middle of connecting
 
     if (!timer_item->bActiveWhenClosed)
       if (m_iConnectPhase != eConnectConnectedToMud)
+        {
+        TimerQueue.Defer (timer_item);
         continue;
+        }
 
-    // if not ready to fire yet, ignore it
-
-    if (timer_item->tFireTime > tNow)
-      continue;
+    // find its name - it should be in the reverse map unless SortTimers is overdue
+    CTimerRevMap::const_iterator it = GetTimerRevMap ().find (timer_item);
+    if (it == GetTimerRevMap ().end ())
+      {
+      SortTimers ();
+      it = GetTimerRevMap ().find (timer_item);
+      if (it == GetTimerRevMap ().end ())
+        continue;   // not one of ours
+      }
 
-    firedTimersList.insert ((LPCTSTR) strTimerName);       // add to list of fired timers
+    firedTimersList.insert (it->second);       // add to list of fired timers
     }
 
 
@@ -163,6 +261,8 @@ CmcDateTimeSpan tsOneDay (1, 0, 0, 0);
 
     if (timer_item->bOneShot)
       timer_item->bEnabled = false;
+    else
+      TimerQueue.Schedule (timer_item);   // queue for the next time
 
 
 // send timer message, if this timer list is "active"
@@ -265,8 +365,8 @@ CmcDateTimeSpan tsOneDay (1, 0, 0, 0);
     if (timer_item->bOneShot)
       {
       TimerMap.RemoveKey (strTimerName);
+      GetTimerRevMap ().erase (timer_item);   // quicker than SortTimers
       delete timer_item;
-      SortTimers ();
       }
     }   // end of processing each timer
 
@@ -276,6 +376,7 @@ CmcDateTimeSpan tsOneDay (1, 0, 0, 0);
 
 void CMUSHclientDoc::CheckTimers ()
   {
+CSendBatch batch (this);    // timers firing together send together
 
   // make sure status line is showing the right thing (after 5 seconds)
   if (m_pActiveCommandView || m_pActiveOutputView)
@@ -315,6 +416,20 @@ void CMUSHclientDoc::CheckTimers ()
     ConnectSocket();      // reconnect
     }
 
+// check for deleted chat sessions - once per tick, not once per timer list
+
+  for (POSITION chatpos = m_ChatList.GetHeadPosition (); chatpos; )
+    {
+    POSITION oldpos = chatpos;
+    CChatSocket * pSocket = m_ChatList.GetNext (chatpos);
+    if (pSocket->m_bDeleteMe)
+      {
+      m_ChatList.RemoveAt (oldpos);
+      delete pSocket;
+      break;    // list is no longer valid
+      }
+    }
+
   if (m_bEnableTimers)
     {
 
@@ -322,7 +437,7 @@ void CMUSHclientDoc::CheckTimers ()
     if (m_CurrentPlugin)
       return;
 
-    CheckTimerList (GetTimerMap ());
+    CheckTimerList (GetTimerMap (), GetTimerQueue ());
     // do plugins
    for (PluginListIterator pit = m_PluginList.begin (); 
          pit != m_PluginList.end (); 
@@ -330,15 +445,26 @@ void CMUSHclientDoc::CheckTimers ()
       {
       m_CurrentPlugin = *pit;
       if (m_CurrentPlugin->m_bEnabled)
-        CheckTimerList (GetTimerMap ());
+        CheckTimerList (GetTimerMap (), GetTimerQueue ());
       } // end of doing each plugin
     m_CurrentPlugin = NULL;
     }
+
+  // compile a few of the triggers and aliases whose regular expressions were
+  // not compiled when loaded - so they are ready before they are needed
+  if (m_iRegexpsPending > 0 && m_CurrentPlugin == NULL)
+    CompilePendingRegexps (20);
+
   } // end of CMUSHclientDoc::CheckTimers
 
 void CMUSHclientDoc::CheckTickTimers ()
   {
 
+  // if we are collecting output (see CSendBatch), ticks only arrive because a
+  // script is in a message loop (eg. showing a message box) - send it anyway
+  if (m_iSendBatchNesting)
+    FlushSendBatch ();
+
   // timer has kicked in unexpectedly - ignore it
   if (m_CurrentPlugin)
     return;
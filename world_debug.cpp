@@ -1431,6 +1431,7 @@ VARIANT CMUSHclientDoc::Debug(LPCTSTR Command)
     Note (TFormat ("Received: %I64d bytes (%I64d Kb)", m_nBytesIn, nInK));
     Note (TFormat ("Sent: %I64d bytes (%I64d Kb)", m_nBytesOut, nOutK));
     Note (TFormat ("Received %I64d packets, sent %I64d packets.", m_iInputPacketCount, m_iOutputPacketCount));
+    Note (TFormat ("Socket writes: %I64d", m_iOutputWriteCount));
     Note (TFormat ("Total lines received: %ld", m_total_lines));
 
     Note (TFormat ("This connection: Sent %ld lines, received %ld lines.", m_nTotalLinesSent, m_nTotalLinesReceived));
@@ -2314,6 +2315,7 @@ void CMUSHclientDoc::DebugHelper (const CString strAction, CString strArgument)
         }
 
       DebugShow  (Translate ("Match attempts"), pTrigger->regexp->m_iMatchAttempts);
+      DebugShow  (Translate ("Matched by"),     pTrigger->regexp->GetBackendName ());
       }
 
     Note ("");
@@ -54,6 +54,9 @@ int count;
   if (count != SOCKET_ERROR)
     m_pDoc->m_nBytesOut += count; // count bytes out
 
+  if (count > 0)
+    m_pDoc->m_iOutputWriteCount++;  // count writes (compare to packets sent)
+
   if (count > 0)    // good send - do rest later
     m_outstanding_data = m_outstanding_data.Mid (count);
   else
@@ -560,6 +560,7 @@ LONGLONG iCounterFrequency = large_int_frequency.QuadPart;
 
       // add to world plugins (in sequence order)
       m_PluginList.insert (pit, m_CurrentPlugin);
+      PluginSubscribersChanged ();
 
       // now call the OnInstall routine (once it is in the list)
 
@@ -617,7 +618,7 @@ void CMUSHclientDoc::LoadError (const char * sType, const char * sMessage, UINT
                       sType,  // type of thing (eg, trigger)
                       ENDLINE);
 
-  if (m_pLinePositions == NULL)
+  if (m_LineList.GetCapacity () == 0)
     ::AfxMessageBox (str);
   else
     ColourNote (SCRIPTERRORCONTEXTFORECOLOUR, SCRIPTERRORBACKCOLOUR, str);
@@ -1341,14 +1342,17 @@ CString strVariable;
       strRegexp = ConvertToRegularExpression (t->trigger);
       }
 
-  // compile regular expression
+  // check regular expression - it is compiled properly (studied, etc.) when 
+  //  first needed, see CompileTriggerRegexp
 
     try
       {
-      t->regexp = regcomp (strRegexp, (t->ignore_case ? PCRE_CASELESS : 0) |
+      regcheck (strRegexp, (t->ignore_case ? PCRE_CASELESS : 0) |
                             (t->bMultiLine  ? PCRE_MULTILINE : 0) |
                             (m_bUTF_8 ? PCRE_UTF8 : 0)
         );
+      t->bCompilePending = true;
+      m_iRegexpsPending++;
       }
     // catch regexp error and rethrow with proper message
     catch (CException* e)
@@ -1572,15 +1576,18 @@ CString strVariable;
       strRegexp = ConvertToRegularExpression (a->name);
       }
 
-  // compile regular expression
+  // check regular expression - it is compiled properly (studied, etc.) when 
+  //  first needed, see CompileAliasRegexp
 
     try
       {
-      a->regexp = regcomp (strRegexp, (a->bIgnoreCase ? PCRE_CASELESS : 0)
+      regcheck (strRegexp, (a->bIgnoreCase ? PCRE_CASELESS : 0)
 #if ALIASES_USE_UTF8
                                   | (m_bUTF_8 ? PCRE_UTF8 : 0)
 #endif // ALIASES_USE_UTF8
         );
+      a->bCompilePending = true;
+      m_iRegexpsPending++;
       }
     // catch regexp error and rethrow with proper message
     catch (CException* e)
@@ -2019,6 +2026,7 @@ bool bTrim;
     }
 
   GetVariableMap ().SetAt (strVariableName, v);
+  NoteVariableChanged (strVariableName);
 
   CheckUsed (node);   // check we used all attributes
 
@@ -185,6 +185,8 @@ void CXMLparser::BuildStructure (CFile * file)
 
   m_strxmlBuffer.ReleaseBuffer (m_xmlLength);
 
+UINT iStart = 0;    // where the XML itself starts in the buffer
+
   // look for Unicode  (FF FE)
   if ((unsigned char) m_strxmlBuffer [0] == 0xFF &&
       (unsigned char) m_strxmlBuffer [1] == 0xFE)
@@ -209,15 +211,17 @@ void CXMLparser::BuildStructure (CFile * file)
     if ((unsigned char) m_strxmlBuffer [0] == 0xEF &&
         (unsigned char) m_strxmlBuffer [1] == 0xBB &&
         (unsigned char) m_strxmlBuffer [2] == 0xBF)
-      m_strxmlBuffer = m_strxmlBuffer.Mid (3);  // skip them
-
+      iStart = 3;  // skip them (rather than copying the whole file without them)
 
-  // convert tabs to spaces, we don't want tabs in our data
-  m_strxmlBuffer.Replace ('\t', ' ');
+  // we don't want tabs in our data, but rather than converting the whole
+  // buffer here, GetValue and AssembleContent turn them into spaces as they go
 
-  SeeIfBase64 (m_strxmlBuffer);
+  // a file starting with the UTF-8 indicator is text, not base64
+  if (iStart == 0)
+    SeeIfBase64 (m_strxmlBuffer);
 
   m_xmlBuff = m_strxmlBuffer;    // get const char * pointer to buffer
+  m_xmlBuff += iStart;
 
   ProcessNode (m_xmlRoot);  // process root node
 
@@ -298,8 +302,22 @@ int iNameLen;
   // in case spaces before next thing
   SkipSpaces ();
 
-  // construct name from buffer
-  return CString (&m_xmlBuff [iStart], iNameLen);
+  // construct name from buffer - names are repeated over and over (eg. <trigger>)
+  // so we hand back a shared copy of the one we made the first time we saw it
+
+char sName [MAX_XML_NAME_LENGTH + 1];
+CString strName;
+
+  memcpy (sName, &m_xmlBuff [iStart], iNameLen);
+  sName [iNameLen] = 0;
+
+  if (!m_NameMap.Lookup (sName, strName))
+    {
+    strName = sName;
+    m_NameMap.SetAt (sName, sName);
+    }
+
+  return strName;
 
   } // end of CXMLparser::GetName
 
@@ -309,6 +327,7 @@ char cQuote;
 UINT iStart;
 CString strValue;
 int iContentLen;
+bool bTabs = false;
 
   // in case spaces before the value
   SkipSpaces ();
@@ -360,8 +379,11 @@ int iContentLen;
                             sType,
                             sName);
 
+    // tabs become spaces, below
+    if (m_xmlBuff [m_xmlPos] == '\t')
+      bTabs = true;
     // don't let them slip in non-printables 
-    if ((unsigned char) m_xmlBuff [m_xmlPos] < ' ')
+    else if ((unsigned char) m_xmlBuff [m_xmlPos] < ' ')
       ThrowErrorException ("Non-printable character, code %i, not permitted for "
                            "value for %s named '%s'",
                             (int) m_xmlBuff [m_xmlPos], 
@@ -378,7 +400,13 @@ int iContentLen;
   SkipSpaces ();
 
   // construct value from buffer
-  return CString (&m_xmlBuff [iStart], iContentLen);
+  strValue = CString (&m_xmlBuff [iStart], iContentLen);
+
+  // convert tabs to spaces, we don't want tabs in our data
+  if (bTabs)
+    strValue.Replace ('\t', ' ');
+
+  return strValue;
 
   } // end of CXMLparser::GetValue 
 
@@ -426,7 +454,8 @@ UINT iFirstLine = m_xmlLine;
       // don't let them slip in non-printables 
       if ((unsigned char) m_xmlBuff [m_xmlPos] < ' ' &&
           (unsigned char) m_xmlBuff [m_xmlPos] != '\n' && 
-          (unsigned char) m_xmlBuff [m_xmlPos] != '\r')
+          (unsigned char) m_xmlBuff [m_xmlPos] != '\r' &&
+          (unsigned char) m_xmlBuff [m_xmlPos] != '\t')
         ThrowErrorException ("Non-printable character, code %i, not permitted",
                               (int) m_xmlBuff [m_xmlPos]);
 
@@ -478,7 +507,8 @@ UINT iFirstLine = m_xmlLine;
         // don't let them slip in non-printables 
         if ((unsigned char) m_xmlBuff [m_xmlPos] < ' ' &&
             (unsigned char) m_xmlBuff [m_xmlPos] != '\n' && 
-            (unsigned char) m_xmlBuff [m_xmlPos] != '\r')
+            (unsigned char) m_xmlBuff [m_xmlPos] != '\r' &&
+            (unsigned char) m_xmlBuff [m_xmlPos] != '\t')
           ThrowErrorException ("Non-printable character, code %i, not permitted",
                                 (int) m_xmlBuff [m_xmlPos]);
 
@@ -540,7 +570,10 @@ UINT iFirstLine = m_xmlLine;
                               (LPCTSTR) strName);
 
       // remember its name
-      pElement->strName = strPrefix + strName;
+      if (strPrefix.IsEmpty ())
+        pElement->strName = strName;    // shares the name GetName found
+      else
+        pElement->strName = strPrefix + strName;
       pElement->iLine = iLine;
 
       parent.ChildrenList.AddTail (pElement);    // add to parent's list of children
@@ -580,7 +613,9 @@ void CXMLparser::AssembleContent (CXMLelement & node,
    concatenating the contents of its children.
   
    For cross-platform consistency, carriage returns are dropped,
-    and linefeeds become carriage-return/linefeed
+    linefeeds become carriage-return/linefeed, and tabs become spaces
+
+   Entities (such as &lt;) are replaced as we go, except inside <![CDATA[
 
   */
 
@@ -589,7 +624,9 @@ int iContentLen = m_xmlPos - iNodeStart;
 int iLines = m_xmlLine - iFirstLine;    // lines of content
 const char * pi = &m_xmlBuff [iNodeStart];    // copy from
 const char * pl = &m_xmlBuff [m_xmlPos];      // limit of copy
-char * po = node.strContent.GetBuffer (iContentLen + 1 + iLines); // copy to
+int iSize = iContentLen + 1 + iLines;         // room in output buffer
+char * pStart = node.strContent.GetBuffer (iSize);
+char * po = pStart; // copy to
 int iDepth = 0;
 bool bInside = false;
 char cQuote = ' ';
@@ -643,10 +680,8 @@ char cQuote = ' ';
          // make linefeeds into carriage return/linefeed
          if (*pi == '\n')
            *po++ = '\r';
-         // special treatment for ampersands, so they don't get converted
-         // into entities ...
-         if (*pi == '&')
-           *po++ = '\x01';
+         if (*pi == '\t')
+           *po++ = ' ';
          else
           *po++ = *pi;    // copy it
          }
@@ -678,10 +713,35 @@ char cQuote = ' ';
       !bInside && 
       *pi != '\r')
      {
-     // make linefeeds into carriage return/linefeed
-     if (*pi == '\n')
-       *po++ = '\r';
-     *po++ = *pi;    // copy if not inside an element
+     if (*pi == '&')
+       {
+       CString strEntity = GetEntity (pi, pl);   // leaves pi at the ';'
+       int iLength = strEntity.GetLength ();
+       int iUsed = po - pStart;
+
+       // the replacement is usually shorter than the entity, but a custom
+       // one may not be, so make sure there is still room for the rest
+       if (iUsed + iLength + (pl - pi) + iLines + 1 > iSize)
+         {
+         node.strContent.ReleaseBuffer (iUsed);
+         iSize = iUsed + iLength + (pl - pi) + iLines + 1;
+         pStart = node.strContent.GetBuffer (iSize);
+         po = pStart + iUsed;
+         }
+
+       memcpy (po, (LPCTSTR) strEntity, iLength);
+       po += iLength;
+       }
+     else
+       {
+       // make linefeeds into carriage return/linefeed
+       if (*pi == '\n')
+         *po++ = '\r';
+       if (*pi == '\t')
+         *po++ = ' ';
+       else
+         *po++ = *pi;    // copy if not inside an element
+       }
      }
     
     // leaving an element (only occurs 'inside' a <... sequence )
@@ -699,16 +759,7 @@ char cQuote = ' ';
 
     }
   
-  *po = 0;  // terminating null
-  node.strContent.ReleaseBuffer (-1);
-
-  // get rid of entities (such as &lt;) in the content
-
-  node.strContent = ReplaceEntities (node.strContent);
-
-  // now, in case we had <![CDATA[ sections, replace 0x01 by &
-
-  node.strContent.Replace ('\x01', '&');
+  node.strContent.ReleaseBuffer (po - pStart);
 
   } // end of CXMLparser::AssembleContent 
 
@@ -913,15 +964,41 @@ CString strTemp;
 
   } // end of CXMLparser::ProcessEntity 
 
+// p points to an ampersand, pl is the end of the text it is in
+// returns the entity's replacement, and leaves p pointing to its ';'
+
+CString CXMLparser::GetEntity (const char * & p, const char * pl)
+  {
+const char * pEntity;
+
+  p++;    // skip ampersand
+  pEntity = p; // where entity starts
+  if (p < pl && *p == '#')
+    p++;
+  while (p < pl &&
+         (isalnum (*p) ||
+          *p == '-' ||
+          *p == '.' ||
+          *p == '_'))
+         p++;
+
+  if (p >= pl || *p != ';')
+    ThrowErrorException ("No closing \";\" in XML entity argument \"&%s\"", 
+              (LPCTSTR) CString (pEntity, p - pEntity)); 
+
+  CString s (pEntity, p - pEntity);
+  return Get_XML_Entity (s);
+
+  } // end of CXMLparser::GetEntity
+
 CString CXMLparser::ReplaceEntities (const CString strSource)
     {
 
 // look for entities imbedded in the string
 const char * p = strSource;
 const char * pStart = strSource;   // where buffer starts
-const char * pEntity;
+const char * pl = pStart + strSource.GetLength ();  // where it ends
 CString strFixedValue;
-CString strEntity;
 long length;
 
   // quick check to eliminate ones that don't have imbedded entities
@@ -941,22 +1018,7 @@ long length;
       if (length > 0)
         strFixedValue += CString (pStart, length);
 
-      p++;    // skip ampersand
-      pEntity = p; // where entity starts
-      if (*p == '#')
-        p++;
-      while (isalnum (*p) ||
-             *p == '-' ||
-             *p == '.' ||
-             *p == '_')
-             p++;
-
-      if (*p != ';')
-        ThrowErrorException ("No closing \";\" in XML entity argument \"&%s\"", 
-                  (LPCTSTR) CString (pEntity, p - pEntity)); 
-
-      CString s (pEntity, p - pEntity);
-      strFixedValue += Get_XML_Entity (s);    // add to list
+      strFixedValue += GetEntity (p, pl);    // add to list
   
       pStart = p + 1;   // move on past the entity
 
@@ -53,7 +53,8 @@ class CXMLelement : public CObject
     bEmpty = false;
     bUsed = false;
     iLine = 1;
-    AttributeMap.InitHashTable (127);
+    // the map's default (small) hash table is only allocated when the first
+    //  attribute is added, so elements like <send> cost nothing here
     };    // constructor
 
   // destructor deletes attributes and children
@@ -73,6 +74,8 @@ class CXMLparser : public CObject
   UINT m_xmlLength;  // size of XML buffer
   UINT m_xmlPos;     // where we are in the buffer
 
+  CMapStringToString m_NameMap;   // element/attribute names seen so far (shared copies)
+
   void SkipComments (const bool bAndSpaces);
   void SkipSpaces (void);
   void ProcessNode (CXMLelement & parent);
@@ -86,6 +89,7 @@ class CXMLparser : public CObject
                         const UINT iNodeStart);
 
   CString ReplaceEntities (const CString strSource);
+  CString GetEntity (const char * & p, const char * pl);
   CString GetName (const char * sType);
   CString GetValue (const char * sType, const char * sName);
 
@@ -101,6 +105,7 @@ class CXMLparser : public CObject
     m_xmlLine = 1;  // first line is line 1
     m_xmlPos = 0;   // start at start of buffer
     m_xmlLength = 0;
+    m_NameMap.InitHashTable (127);
 
     }; // end of constructor
 